@@ -0,0 +1,389 @@
+#include "CliApp.h"
+#include "BatchManifest.h"
+#include "FileWatcher.h"
+#include "ImageLoader.h"
+#include "ORMGenerator.h"
+#include "PlaneCache.h"
+
+#include <atomic>
+#include <csignal>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <set>
+#include <string_view>
+#include <thread>
+
+namespace
+{
+	volatile std::sig_atomic_t StopRequested = 0;
+
+	void RequestStop(int)
+	{
+		StopRequested = 1;
+	}
+
+	/** Parses a non-negative integer option value; returns false on garbage. */
+	bool ParseCount(const char* text, int& value, long maxValue = 65536)
+	{
+		char* end = nullptr;
+		const long parsed = std::strtol(text, &end, 10);
+		if(end == text || *end != '\0' || parsed < 0 || parsed > maxValue)
+		{
+			return false;
+		}
+		value = static_cast<int>(parsed);
+		return true;
+	}
+}
+
+void CliApplication::PrintUsage(std::ostream& out)
+{
+	out <<
+		"Usage: ormtool-cli --ao <file> --rough <file> --metal <file> [--unreal <file>] [--unity <file>] [options]\n"
+		"       ormtool-cli --batch <manifest.csv> [options]\n"
+		"\n"
+		"Packs ambient occlusion, roughness and metallic maps into ORM textures.\n"
+		"At least one of --unreal (RGB: AO, roughness, metallic) or --unity (RGBA: metallic, AO, -, smoothness) is required.\n"
+		"A manifest has a header row naming the columns ao, rough, metal, unreal, unity and optionally resolution,\n"
+		"ao_channel, rough_channel and metal_channel;\n"
+		"the options below apply to every row.\n"
+		"\n"
+		"Options:\n"
+		"  --ao-channel <c>   source channel of the AO input: luma (default), r, g, b or a;\n"
+		"                     --rough-channel and --metal-channel likewise\n"
+		"  --resolution <px>  output width; inputs are resampled (default: widest input)\n"
+		"  --fast             fast PNG compression for iteration builds\n"
+		"  --16bit            decode, pack and write 16-bit samples (8-bit inputs are widened)\n"
+		"  --dither           8-bit output: dither 16-bit inputs down instead of truncating them\n"
+		"  --streaming        pack and encode band by band with bounded memory\n"
+		"  --threads <n>      threads per stage (default: all cores)\n"
+		"  --jobs <n>         batch: materials processed at once (default: one per core)\n"
+		"  --memory <MiB>     batch: memory budget for all jobs in flight and the decode cache\n"
+		"                     (default: 3/4 of RAM)\n"
+		"  --cache <dir>      reuse outputs whose inputs and settings are unchanged\n"
+		"  --decode-cache <MiB> decoded inputs kept for reuse across jobs (default: 512, 0 = off)\n"
+		"  --plane-store <dir> decoded inputs shared between runs, mapped instead of decoded\n"
+		"  --watch            keep running and regenerate the sets whose inputs change\n"
+		"  --quiet            no progress output\n"
+		"  --help             show this text\n";
+}
+
+bool CliApplication::ParseArguments(int argc, char** argv)
+{
+	job.generateUnreal = false;
+	job.generateUnity = false;
+
+	for(int i = 1; i < argc; ++i)
+	{
+		const std::string_view arg = argv[i];
+		const bool hasValue = i + 1 < argc;
+
+		if(arg == "--help" || arg == "-h")
+		{
+			showHelp = true;
+		}
+		else if(arg == "--fast")
+		{
+			job.pngOptions.compression = PngCompression::Fast;
+		}
+		else if(arg == "--streaming")
+		{
+			job.streaming = true;
+		}
+		else if(arg == "--16bit")
+		{
+			job.pngOptions.bitDepth = 16;
+		}
+		else if(arg == "--dither")
+		{
+			job.dither = true;
+		}
+		else if(arg == "--watch")
+		{
+			watch = true;
+		}
+		else if(arg == "--quiet" || arg == "-q")
+		{
+			quiet = true;
+		}
+		else if(!hasValue)
+		{
+			std::cerr << "Missing value or unknown option: " << arg << "\n";
+			return false;
+		}
+		else if(arg == "--ao")
+		{
+			job.ao = argv[++i];
+		}
+		else if(arg == "--rough")
+		{
+			job.rough = argv[++i];
+		}
+		else if(arg == "--metal")
+		{
+			job.metal = argv[++i];
+		}
+		else if(arg == "--ao-channel" || arg == "--rough-channel" || arg == "--metal-channel")
+		{
+			SourceChannel& channel = arg == "--ao-channel" ? job.aoChannel : arg == "--rough-channel" ? job.roughChannel : job.metalChannel;
+			if(!ImageLoader::ParseChannel(argv[++i], channel))
+			{
+				std::cerr << "Invalid channel: " << argv[i] << "\n";
+				return false;
+			}
+		}
+		else if(arg == "--unreal")
+		{
+			job.saveUnrealPath = argv[++i];
+			job.generateUnreal = true;
+		}
+		else if(arg == "--unity")
+		{
+			job.saveUnityPath = argv[++i];
+			job.generateUnity = true;
+		}
+		else if(arg == "--resolution")
+		{
+			if(!ParseCount(argv[++i], job.targetResolution))
+			{
+				std::cerr << "Invalid resolution: " << argv[i] << "\n";
+				return false;
+			}
+		}
+		else if(arg == "--cache")
+		{
+			job.cacheDirectory = argv[++i];
+		}
+		else if(arg == "--decode-cache")
+		{
+			int mebibytes = 0;
+			if(!ParseCount(argv[++i], mebibytes, 1L << 30))
+			{
+				std::cerr << "Invalid decode cache size: " << argv[i] << "\n";
+				return false;
+			}
+			PlaneCache::Get().SetBudget(static_cast<size_t>(mebibytes) * 1024 * 1024);
+		}
+		else if(arg == "--plane-store")
+		{
+			PlaneCache::Get().SetStoreDirectory(argv[++i]);
+		}
+		else if(arg == "--batch")
+		{
+			manifestPath = argv[++i];
+		}
+		else if(arg == "--jobs")
+		{
+			int jobs = 0;
+			if(!ParseCount(argv[++i], jobs))
+			{
+				std::cerr << "Invalid job count: " << argv[i] << "\n";
+				return false;
+			}
+			batchOptions.maxJobs = static_cast<unsigned int>(jobs);
+		}
+		else if(arg == "--memory")
+		{
+			int mebibytes = 0;
+			if(!ParseCount(argv[++i], mebibytes, 1L << 30))
+			{
+				std::cerr << "Invalid memory budget: " << argv[i] << "\n";
+				return false;
+			}
+			batchOptions.memoryBudget = static_cast<size_t>(mebibytes) * 1024 * 1024;
+		}
+		else if(arg == "--threads")
+		{
+			int threads = 0;
+			if(!ParseCount(argv[++i], threads))
+			{
+				std::cerr << "Invalid thread count: " << argv[i] << "\n";
+				return false;
+			}
+			job.workerCount = static_cast<unsigned int>(threads);
+			job.pngOptions.workerCount = job.workerCount;
+		}
+		else
+		{
+			std::cerr << "Unknown option: " << arg << "\n";
+			return false;
+		}
+	}
+
+	if(showHelp || !manifestPath.empty())
+	{
+		return true;
+	}
+
+	if(job.ao.empty() || job.rough.empty() || job.metal.empty())
+	{
+		std::cerr << "--ao, --rough and --metal are required\n";
+		return false;
+	}
+
+	if(!job.generateUnreal && !job.generateUnity)
+	{
+		std::cerr << "Nothing to do: pass --unreal and/or --unity\n";
+		return false;
+	}
+
+	return true;
+}
+
+CliStatus CliApplication::Run(int argc, char** argv)
+{
+	if(!ParseArguments(argc, argv))
+	{
+		PrintUsage(std::cerr);
+		return CliStatus::InvalidArguments;
+	}
+
+	if(showHelp)
+	{
+		PrintUsage(std::cout);
+		return CliStatus::OK;
+	}
+
+	if(!manifestPath.empty())
+	{
+		std::string error;
+		if(!BatchManifest::LoadCsv(manifestPath, job, manifestJobs, error))
+		{
+			std::cerr << "Invalid manifest: " << error << "\n";
+			return CliStatus::InvalidArguments;
+		}
+	}
+
+	const CliStatus status = manifestPath.empty() ? RunSingle() : RunBatch();
+	return watch ? Watch() : status;
+}
+
+CliStatus CliApplication::RunSingle()
+{
+	// progress arrives from any worker; print whole percent steps only
+	std::mutex printMutex;
+	std::atomic<int> printedPercent{-1};
+	if(!quiet)
+	{
+		job.progressCallback = [&](float progress)
+		{
+			const int percent = static_cast<int>(progress * 100.0f);
+			int previous = printedPercent.load();
+			while(percent > previous)
+			{
+				if(printedPercent.compare_exchange_weak(previous, percent))
+				{
+					std::lock_guard<std::mutex> lock(printMutex);
+					std::cerr << "\r" << percent << "%" << std::flush;
+					break;
+				}
+			}
+		};
+	}
+
+	const auto start = std::chrono::steady_clock::now();
+	const bool generated = ORMGenerator::Generate(job);
+	const auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	if(!quiet)
+	{
+		std::cerr << "\r";
+	}
+
+	if(!generated)
+	{
+		std::cerr << "Generation failed\n";
+		return CliStatus::Failed;
+	}
+
+	if(!quiet)
+	{
+		if(job.generateUnreal) std::cout << "Wrote " << job.saveUnrealPath << "\n";
+		if(job.generateUnity) std::cout << "Wrote " << job.saveUnityPath << "\n";
+		std::cout << "Done in " << elapsed << " s\n";
+	}
+
+	return CliStatus::OK;
+}
+
+BatchResult CliApplication::RunJobs(const std::vector<SaveData>& jobs)
+{
+	const auto start = std::chrono::steady_clock::now();
+	size_t finished = 0;
+	const BatchResult result = BatchScheduler::Run(jobs, batchOptions, [&](size_t index, bool succeeded)
+	{
+		++finished;
+		if(!quiet || !succeeded)
+		{
+			const SaveData& done = jobs[index];
+			(succeeded ? std::cout : std::cerr) << "[" << finished << "/" << jobs.size() << "] "
+				<< (succeeded ? "done " : "FAILED ") << (done.generateUnreal ? done.saveUnrealPath : done.saveUnityPath) << "\n";
+		}
+	});
+	const auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	if(!quiet)
+	{
+		std::cout << result.succeeded << " succeeded, " << result.failed << " failed in " << elapsed << " s\n";
+	}
+	return result;
+}
+
+CliStatus CliApplication::RunBatch()
+{
+	return RunJobs(manifestJobs).failed ? CliStatus::Failed : CliStatus::OK;
+}
+
+CliStatus CliApplication::Watch()
+{
+	std::vector<SaveData> jobs = manifestPath.empty() ? std::vector<SaveData>{ job } : manifestJobs;
+	for(SaveData& watched : jobs)
+	{
+		watched.progressCallback = nullptr;
+	}
+
+	FileWatcher watcher;
+	for(const SaveData& watched : jobs)
+	{
+		watcher.Watch(watched.ao);
+		watcher.Watch(watched.rough);
+		watcher.Watch(watched.metal);
+	}
+
+	std::signal(SIGINT, RequestStop);
+	std::signal(SIGTERM, RequestStop);
+	std::cout << "Watching " << jobs.size() << (jobs.size() == 1 ? " set" : " sets") << " for changes, Ctrl+C to stop\n" << std::flush;
+
+	while(!StopRequested)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+		const std::vector<std::string> changedFiles = watcher.Poll();
+		if(changedFiles.empty())
+		{
+			continue;
+		}
+
+		// Only the sets that read one of the changed files are generated again
+		const std::set<std::string> changed(changedFiles.begin(), changedFiles.end());
+		std::vector<SaveData> affected;
+		for(const SaveData& watched : jobs)
+		{
+			if(changed.count(FileWatcher::NormalizePath(watched.ao)) || changed.count(FileWatcher::NormalizePath(watched.rough))
+				|| changed.count(FileWatcher::NormalizePath(watched.metal)))
+			{
+				affected.push_back(watched);
+			}
+		}
+
+		for(const std::string& file : changedFiles)
+		{
+			std::cout << "Changed: " << file << "\n";
+		}
+		(void)RunJobs(affected);
+	}
+
+	return CliStatus::OK;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "BatchScheduler.h"
+#include "Types.h"
+
+enum class CliStatus : int
+{
+	OK = 0,
+	Failed = 1,
+	InvalidArguments = 2
+};
+
+/**
+ * CliApplication
+ *
+ * Headless front end of the packing engine for scripted and farm use: either one job
+ * described on the command line or a CSV manifest run through BatchScheduler, optionally
+ * followed by watch mode, which regenerates the sets whose inputs are re-exported.
+ * Links no GL, ImGui or NFD code.
+ */
+class CliApplication
+{
+public:
+	[[nodiscard]] CliStatus Run(int argc, char** argv);
+
+	static void PrintUsage(std::ostream& out);
+
+private:
+	[[nodiscard]] bool ParseArguments(int argc, char** argv);
+	[[nodiscard]] CliStatus RunSingle();
+	[[nodiscard]] CliStatus RunBatch();
+	[[nodiscard]] BatchResult RunJobs(const std::vector<SaveData>& jobs);
+	[[nodiscard]] CliStatus Watch();
+
+	SaveData job;				// the single job, or the defaults for every manifest row
+	std::vector<SaveData> manifestJobs;
+	std::string manifestPath;
+	BatchOptions batchOptions;
+	bool quiet = false;
+	bool showHelp = false;
+	bool watch = false;
+};
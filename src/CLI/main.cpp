@@ -0,0 +1,8 @@
+#include "CliApp.h"
+
+
+int main(int argc, char** argv)
+{
+	CliApplication app;
+	return static_cast<int>(app.Run(argc, argv));
+}
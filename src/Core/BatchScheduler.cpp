@@ -0,0 +1,149 @@
+#include "BatchScheduler.h"
+#include "ImageLoader.h"
+#include "ORMGenerator.h"
+#include "PlaneCache.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+#ifdef _WIN32
+	#ifndef NOMINMAX
+		#define NOMINMAX
+	#endif
+	#include <windows.h>
+#else
+	#include <unistd.h>
+#endif
+
+size_t BatchScheduler::EstimateMemory(const SaveData& job)
+{
+	// Fixed allowance for band buffers, encoder state and the decoder's own scratch
+	static constexpr size_t Overhead = 32ull * 1024 * 1024;
+
+	// dithered jobs decode at 16 bits but pack 8-bit samples
+	const size_t sampleBytes = job.pngOptions.bitDepth == 16 || job.dither ? 2 : 1;
+	const size_t packedBytes = job.pngOptions.bitDepth == 16 ? 2 : 1;
+	const std::string* inputs[3] = { &job.ao, &job.rough, &job.metal };
+	size_t decoded = 0;
+	int widest = 0;
+	int widestHeight = 0;
+	for(const std::string* input : inputs)
+	{
+		int width = 0, height = 0, channels = 0;
+		if(!ImageLoader::GetInfo(*input, width, height, channels))
+		{
+			continue;	// the job will fail early; nothing big gets allocated
+		}
+
+		// stb decodes at the stored channel count and then converts to gray
+		decoded += static_cast<size_t>(width) * height * (static_cast<size_t>(channels) + 1) * sampleBytes;
+		if(width > widest)
+		{
+			widest = width;
+			widestHeight = height;
+		}
+	}
+
+	size_t width = static_cast<size_t>(widest);
+	size_t height = static_cast<size_t>(widestHeight);
+	if(job.targetResolution > 0 && widest > 0)
+	{
+		height = std::max<size_t>(1, height * job.targetResolution / widest);
+		width = static_cast<size_t>(job.targetResolution);
+	}
+
+	const size_t pixels = width * height;
+	const size_t resampled = pixels * 3 * sampleBytes;
+	const size_t packed = job.streaming ? 0 : pixels * ((job.generateUnreal ? 3 : 0) + (job.generateUnity ? 4 : 0)) * packedBytes;
+	return decoded + resampled + packed + Overhead;
+}
+
+size_t BatchScheduler::GetPhysicalMemory()
+{
+#ifdef _WIN32
+	MEMORYSTATUSEX status{};
+	status.dwLength = sizeof(status);
+	return GlobalMemoryStatusEx(&status) ? static_cast<size_t>(status.ullTotalPhys) : 0;
+#else
+	const long pages = sysconf(_SC_PHYS_PAGES);
+	const long pageSize = sysconf(_SC_PAGESIZE);
+	return pages > 0 && pageSize > 0 ? static_cast<size_t>(pages) * static_cast<size_t>(pageSize) : 0;
+#endif
+}
+
+BatchResult BatchScheduler::Run(const std::vector<SaveData>& jobs, const BatchOptions& options,
+	const std::function<void(size_t, bool)>& onJobFinished)
+{
+	const unsigned int maxJobs = options.maxJobs ? options.maxJobs : std::max(1u, std::thread::hardware_concurrency());
+	size_t budget = options.memoryBudget;
+	if(!budget)
+	{
+		const size_t physical = GetPhysicalMemory();
+		budget = physical ? physical / 4 * 3 : SIZE_MAX;
+	}
+
+	// Planes PlaneCache keeps between jobs (store mappings included) stay resident beside them
+	const size_t cacheBudget = PlaneCache::Get().GetBudget();
+	budget = budget > cacheBudget ? budget - cacheBudget : 0;
+
+	ThreadPool& pool = ThreadPool::Get();
+	std::mutex mutex;
+	std::condition_variable jobFinished;
+	std::mutex callbackMutex;
+	unsigned int running = 0;
+	size_t memoryInUse = 0;
+	BatchResult result;
+
+	// This thread only admits jobs: helping with queued pool work could pick up a whole posted
+	// job and hold admission back until it finished
+	for(size_t index = 0; index < jobs.size(); ++index)
+	{
+		const size_t estimate = EstimateMemory(jobs[index]);
+
+		std::unique_lock<std::mutex> lock(mutex);
+		jobFinished.wait(lock, [&]() { return running == 0 || (running < maxJobs && memoryInUse + estimate <= budget); });
+		++running;
+		memoryInUse += estimate;
+		lock.unlock();
+
+		pool.Post([&, index, estimate]()
+		{
+			// a job that throws (bad_alloc on a huge input) fails alone instead of ending the batch
+			bool succeeded = false;
+			try
+			{
+				succeeded = ORMGenerator::Generate(jobs[index]);
+			}
+			catch(const std::exception& error)
+			{
+				std::cerr << "Failed to generate: " << error.what() << "\n";
+			}
+			catch(...)
+			{
+				std::cerr << "Failed to generate: unknown error\n";
+			}
+
+			if(onJobFinished)
+			{
+				std::lock_guard<std::mutex> callbackLock(callbackMutex);
+				onJobFinished(index, succeeded);
+			}
+
+			std::lock_guard<std::mutex> finishedLock(mutex);
+			--running;
+			memoryInUse -= estimate;
+			++(succeeded ? result.succeeded : result.failed);
+			jobFinished.notify_all();
+		});
+	}
+
+	std::unique_lock<std::mutex> lock(mutex);
+	jobFinished.wait(lock, [&]() { return running == 0; });
+	return result;
+}
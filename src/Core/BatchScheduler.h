@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+#include "Types.h"
+
+struct BatchOptions
+{
+	unsigned int maxJobs = 0;	// jobs in flight, 0 = one per hardware thread
+	size_t memoryBudget = 0;	// bytes all jobs in flight and the decode cache may use together, 0 = 3/4 of physical memory
+};
+
+struct BatchResult
+{
+	size_t succeeded = 0;
+	size_t failed = 0;
+};
+
+/**
+ * BatchScheduler
+ *
+ * Runs many SaveData jobs concurrently on the shared ThreadPool. Jobs start in order while
+ * fewer than maxJobs are running and their estimated peak memory fits the budget next to
+ * the jobs already running and the PlaneCache budget; a job larger than what is left runs
+ * alone. Overlapping jobs keeps the cores busy while others wait on decode or file I/O.
+ */
+class BatchScheduler
+{
+public:
+	/** Peak bytes a job is expected to hold, estimated from the input headers. */
+	static size_t EstimateMemory(const SaveData& job);
+
+	/** Installed physical memory in bytes, 0 if unknown. */
+	static size_t GetPhysicalMemory();
+
+	/**
+	 * Runs every job and returns once all finished. The calling thread only admits jobs, so it
+	 * must not be a pool worker. onJobFinished(index, succeeded) is called from the thread that
+	 * ran the job, at most one call at a time.
+	 */
+	static BatchResult Run(const std::vector<SaveData>& jobs, const BatchOptions& options = {},
+		const std::function<void(size_t, bool)>& onJobFinished = nullptr);
+};
@@ -0,0 +1,131 @@
+#include "ContentHash.h"
+#include "MappedFile.h"
+
+#include <cstring>
+
+namespace
+{
+	constexpr uint64_t Prime1 = 0x9E3779B185EBCA87ull;
+	constexpr uint64_t Prime2 = 0xC2B2AE3D27D4EB4Full;
+	constexpr uint64_t Prime3 = 0x165667B19E3779F9ull;
+	constexpr uint64_t Prime4 = 0x85EBCA77C2B2AE63ull;
+	constexpr uint64_t Prime5 = 0x27D4EB2F165667C5ull;
+
+	inline uint64_t RotateLeft(uint64_t value, int bits)
+	{
+		return (value << bits) | (value >> (64 - bits));
+	}
+
+	// unaligned little-endian reads; every supported target is little-endian
+	inline uint64_t Read64(const uint8_t* p)
+	{
+		uint64_t value;
+		std::memcpy(&value, p, sizeof(value));
+		return value;
+	}
+
+	inline uint32_t Read32(const uint8_t* p)
+	{
+		uint32_t value;
+		std::memcpy(&value, p, sizeof(value));
+		return value;
+	}
+
+	inline uint64_t Round(uint64_t acc, uint64_t input)
+	{
+		acc += input * Prime2;
+		acc = RotateLeft(acc, 31);
+		return acc * Prime1;
+	}
+
+	inline uint64_t MergeRound(uint64_t acc, uint64_t value)
+	{
+		acc ^= Round(0, value);
+		return acc * Prime1 + Prime4;
+	}
+}
+
+uint64_t ContentHash::Hash(const void* data, size_t size, uint64_t seed)
+{
+	const uint8_t* p = static_cast<const uint8_t*>(data);
+	const uint8_t* const end = p + size;
+	uint64_t hash;
+
+	if(size >= 32)
+	{
+		// four independent lanes keep the multipliers busy; this loop is where all the time goes
+		uint64_t v1 = seed + Prime1 + Prime2;
+		uint64_t v2 = seed + Prime2;
+		uint64_t v3 = seed;
+		uint64_t v4 = seed - Prime1;
+		const uint8_t* const limit = end - 32;
+		do
+		{
+			v1 = Round(v1, Read64(p));
+			v2 = Round(v2, Read64(p + 8));
+			v3 = Round(v3, Read64(p + 16));
+			v4 = Round(v4, Read64(p + 24));
+			p += 32;
+		}
+		while(p <= limit);
+
+		hash = RotateLeft(v1, 1) + RotateLeft(v2, 7) + RotateLeft(v3, 12) + RotateLeft(v4, 18);
+		hash = MergeRound(hash, v1);
+		hash = MergeRound(hash, v2);
+		hash = MergeRound(hash, v3);
+		hash = MergeRound(hash, v4);
+	}
+	else
+	{
+		hash = seed + Prime5;
+	}
+
+	hash += static_cast<uint64_t>(size);
+
+	for(; p + 8 <= end; p += 8)
+	{
+		hash ^= Round(0, Read64(p));
+		hash = RotateLeft(hash, 27) * Prime1 + Prime4;
+	}
+	if(p + 4 <= end)
+	{
+		hash ^= static_cast<uint64_t>(Read32(p)) * Prime1;
+		hash = RotateLeft(hash, 23) * Prime2 + Prime3;
+		p += 4;
+	}
+	for(; p < end; ++p)
+	{
+		hash ^= *p * Prime5;
+		hash = RotateLeft(hash, 11) * Prime1;
+	}
+
+	hash ^= hash >> 33;
+	hash *= Prime2;
+	hash ^= hash >> 29;
+	hash *= Prime3;
+	hash ^= hash >> 32;
+	return hash;
+}
+
+bool ContentHash::HashFile(const std::string& path, uint64_t& hash)
+{
+	MappedFile file;
+	if(!file.Open(path))
+	{
+		return false;
+	}
+
+	hash = Hash(file.GetData(), file.GetSize());
+	return true;
+}
+
+std::string ContentHash::ToHex(uint64_t hash)
+{
+	static constexpr char Digits[] = "0123456789abcdef";
+	std::string text(16, '0');
+	for(int i = 15; i >= 0; --i, hash >>= 4)
+	{
+		text[i] = Digits[hash & 0xF];
+	}
+	return text;
+}
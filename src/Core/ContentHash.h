@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * ContentHash
+ *
+ * 64-bit XXH64 of raw bytes, used to recognise inputs by content rather than by name or
+ * timestamp. Not cryptographic; collisions between distinct textures are negligible at
+ * the scale of an asset library.
+ */
+class ContentHash
+{
+public:
+	static uint64_t Hash(const void* data, size_t size, uint64_t seed = 0);
+
+	/** Hashes the whole file through a read-only mapping. Returns false if it cannot be read. */
+	static bool HashFile(const std::string& path, uint64_t& hash);
+
+	/** Fixed-width lowercase hex, suitable as a file name. */
+	static std::string ToHex(uint64_t hash);
+};
@@ -0,0 +1,70 @@
+#include "CpuFeatures.h"
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+	#include <intrin.h>
+	#define ORM_CPU_X86_MSVC 1
+#elif defined(__x86_64__) || defined(__i386__)
+	#define ORM_CPU_X86_GNU 1
+#endif
+
+namespace
+{
+	struct FeatureFlags
+	{
+		bool sse2 = false;
+		bool ssse3 = false;
+		bool avx2 = false;
+	};
+
+	FeatureFlags DetectFeatures()
+	{
+		FeatureFlags flags;
+
+#if defined(ORM_CPU_X86_MSVC)
+		int info[4] = {};
+		__cpuid(info, 0);
+		const int maxLeaf = info[0];
+
+		__cpuid(info, 1);
+		flags.sse2 = (info[3] & (1 << 26)) != 0;
+		flags.ssse3 = (info[2] & (1 << 9)) != 0;
+		const bool osxsave = (info[2] & (1 << 27)) != 0;
+		const bool avx = (info[2] & (1 << 28)) != 0;
+
+		if(maxLeaf >= 7 && osxsave && avx)
+		{
+			const bool ymmEnabled = (_xgetbv(0) & 0x6) == 0x6;
+			__cpuidex(info, 7, 0);
+			flags.avx2 = ymmEnabled && (info[1] & (1 << 5)) != 0;
+		}
+#elif defined(ORM_CPU_X86_GNU)
+		__builtin_cpu_init();
+		flags.sse2 = __builtin_cpu_supports("sse2");
+		flags.ssse3 = __builtin_cpu_supports("ssse3");
+		flags.avx2 = __builtin_cpu_supports("avx2");
+#endif
+
+		return flags;
+	}
+
+	const FeatureFlags& GetFeatures()
+	{
+		static const FeatureFlags features = DetectFeatures();
+		return features;
+	}
+}
+
+bool CpuFeatures::HasSSE2()
+{
+	return GetFeatures().sse2;
+}
+
+bool CpuFeatures::HasSSSE3()
+{
+	return GetFeatures().ssse3;
+}
+
+bool CpuFeatures::HasAVX2()
+{
+	return GetFeatures().avx2;
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+/**
+ * CpuFeatures
+ *
+ * Runtime detection of the x86 SIMD extensions used by the image kernels.
+ * The result is computed once and cached; on non-x86 targets every query returns false.
+ */
+class CpuFeatures
+{
+public:
+	/** True when SSE2 is available. */
+	static bool HasSSE2();
+
+	/** True when SSSE3 (pshufb) is available. */
+	static bool HasSSSE3();
+
+	/** True when AVX2 is available and enabled by the operating system. */
+	static bool HasAVX2();
+};
@@ -0,0 +1,84 @@
+#include "MipPyramid.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+MipLevel MipPyramid::Downsample(const uint8_t* pixels, int width, int height, int channels)
+{
+	MipLevel level;
+	level.width = std::max(1, width / 2);
+	level.height = std::max(1, height / 2);
+	level.pixels.resize(static_cast<size_t>(level.width) * level.height * channels);
+
+	const size_t srcStride = static_cast<size_t>(width) * channels;
+	const size_t dstStride = static_cast<size_t>(level.width) * channels;
+
+	// rows are independent; small levels stay on the calling thread
+	const size_t rowsPerTask = std::max<size_t>(1, (64 * 1024) / std::max<size_t>(1, dstStride));
+	const size_t taskCount = (static_cast<size_t>(level.height) + rowsPerTask - 1) / rowsPerTask;
+
+	ThreadPool::Get().ParallelFor(taskCount, [&](size_t task)
+	{
+		const size_t firstRow = task * rowsPerTask;
+		const size_t lastRow = std::min(static_cast<size_t>(level.height), firstRow + rowsPerTask);
+		for(size_t y = firstRow; y < lastRow; ++y)
+		{
+			const uint8_t* row0 = pixels + std::min(2 * y, static_cast<size_t>(height - 1)) * srcStride;
+			const uint8_t* row1 = pixels + std::min(2 * y + 1, static_cast<size_t>(height - 1)) * srcStride;
+			uint8_t* out = level.pixels.data() + y * dstStride;
+
+			for(int x = 0; x < level.width; ++x)
+			{
+				const size_t x0 = static_cast<size_t>(std::min(2 * x, width - 1)) * channels;
+				const size_t x1 = static_cast<size_t>(std::min(2 * x + 1, width - 1)) * channels;
+				for(int c = 0; c < channels; ++c)
+				{
+					const unsigned sum = row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c];
+					out[static_cast<size_t>(x) * channels + c] = static_cast<uint8_t>((sum + 2) >> 2);
+				}
+			}
+		}
+	});
+
+	return level;
+}
+
+std::vector<MipLevel> MipPyramid::Build(const uint8_t* pixels, int width, int height, int channels, int fitWidth, int fitHeight)
+{
+	std::vector<MipLevel> levels;
+	if(!pixels || width <= 0 || height <= 0 || channels <= 0)
+	{
+		return levels;
+	}
+
+	MipLevel current;
+	const uint8_t* src = pixels;
+	int w = width;
+	int h = height;
+
+	// skip the levels that are still larger than needed, keeping one of them alive at a time
+	while(w / 2 >= fitWidth && h / 2 >= fitHeight && (w > 1 || h > 1))
+	{
+		current = Downsample(src, w, h, channels);
+		src = current.pixels.data();
+		w = current.width;
+		h = current.height;
+	}
+
+	if(current.pixels.empty())
+	{
+		current.pixels.assign(pixels, pixels + static_cast<size_t>(width) * height * channels);
+		current.width = width;
+		current.height = height;
+	}
+	levels.push_back(std::move(current));
+
+	while(levels.back().width > 1 || levels.back().height > 1)
+	{
+		const MipLevel& last = levels.back();
+		MipLevel next = Downsample(last.pixels.data(), last.width, last.height, channels);
+		levels.push_back(std::move(next));
+	}
+
+	return levels;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/** One level of a mip chain, tightly packed rows. */
+struct MipLevel
+{
+	std::vector<uint8_t> pixels;
+	int width = 0;
+	int height = 0;
+};
+
+/**
+ * MipPyramid
+ *
+ * Builds mip chains with a 2x2 box filter, rows split across the shared ThreadPool. Levels
+ * larger than the requested fit size are only produced transiently, so the result scales
+ * with the display size rather than the source size.
+ */
+class MipPyramid
+{
+public:
+	/**
+	 * Returns the chain starting at the smallest halving of the source that still covers
+	 * fitWidth x fitHeight (the source itself if it is already smaller) down to 1x1.
+	 */
+	static std::vector<MipLevel> Build(const uint8_t* pixels, int width, int height, int channels, int fitWidth, int fitHeight);
+
+	/** Halves the image into a new level; odd edges are clamped. */
+	static MipLevel Downsample(const uint8_t* pixels, int width, int height, int channels);
+};
@@ -0,0 +1,257 @@
+#include "ORMGenerator.h"
+#include "ImageLoader.h"
+#include "ORMPacker.h"
+#include "OutputCache.h"
+#include "PlaneCache.h"
+#include "PngWriter.h"
+#include "Resampler.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <future>
+#include <iostream>
+
+namespace
+{
+	/** Waits for a pool task on every exit path, so an exception here never unwinds state the task still reads. */
+	template<typename T>
+	class TaskWaiter
+	{
+	public:
+		explicit TaskWaiter(const std::future<T>& future)
+			: future(future)
+		{
+		}
+
+		~TaskWaiter()
+		{
+			if(future.valid())
+			{
+				ThreadPool::Get().Wait(future);
+			}
+		}
+
+		TaskWaiter(const TaskWaiter&) = delete;
+		TaskWaiter& operator=(const TaskWaiter&) = delete;
+
+	private:
+		const std::future<T>& future;
+	};
+}
+
+bool ORMGenerator::Generate(const SaveData& job, PreviewImage* preview, int previewFitWidth)
+{
+	const bool doUnreal = job.generateUnreal && !job.saveUnrealPath.empty();
+	const bool doUnity = job.generateUnity && !job.saveUnityPath.empty();
+	const std::function<void(float)>& progressCallback = job.progressCallback;
+	if(!doUnreal && !doUnity)
+	{
+		return false;
+	}
+
+	// Unchanged inputs with unchanged settings are served from the cache without decoding anything
+	const OutputCache cache(job);
+	if(!preview && cache.Restore())
+	{
+		if(progressCallback)
+		{
+			progressCallback(1.0f);
+		}
+		return true;
+	}
+
+	// The three decodes are independent; AO and roughness go to the pool while this thread decodes metallic.
+	// Inputs shared between jobs (a common AO, a flat metallic) come out of PlaneCache already decoded.
+	// 16-bit output keeps 16-bit samples from decode to file; 8-bit sources are widened losslessly.
+	// Dithered 8-bit output decodes at 16 bits too, unless no input has more than 8 to keep.
+	const bool dither = job.dither && job.pngOptions.bitDepth != 16
+		&& (ImageLoader::Is16Bit(job.ao) || ImageLoader::Is16Bit(job.rough) || ImageLoader::Is16Bit(job.metal));
+	const int bitDepth = job.pngOptions.bitDepth == 16 || dither ? 16 : 8;
+	const size_t sampleBytes = static_cast<size_t>(bitDepth / 8);
+	const size_t packedBytes = dither ? 1 : sampleBytes;
+	ThreadPool& pool = ThreadPool::Get();
+	PlaneCache& planeCache = PlaneCache::Get();
+	std::future<PlaneHandle> aoTask = pool.Submit([&]() { return planeCache.LoadGrayscale(job.ao, job.aoChannel, bitDepth); });
+	const TaskWaiter<PlaneHandle> aoWaiter(aoTask);
+	std::future<PlaneHandle> roughTask = pool.Submit([&]() { return planeCache.LoadGrayscale(job.rough, job.roughChannel, bitDepth); });
+	const TaskWaiter<PlaneHandle> roughWaiter(roughTask);
+	PlaneHandle decoded[3] = { nullptr, nullptr, planeCache.LoadGrayscale(job.metal, job.metalChannel, bitDepth) };
+	pool.Wait(aoTask);
+	pool.Wait(roughTask);
+	decoded[0] = aoTask.get();
+	decoded[1] = roughTask.get();
+
+	std::vector<unsigned char> resampled[3];
+	const auto freeInputs = [&]()
+	{
+		for(int i = 0; i < 3; ++i)
+		{
+			decoded[i].reset();
+			std::vector<unsigned char>().swap(resampled[i]);
+		}
+	};
+
+	if(!decoded[0] || !decoded[1] || !decoded[2])
+	{
+		freeInputs();
+		return false;
+	}
+
+	// Every input is resampled to the target width (the widest input if none is chosen), keeping the aspect of the widest input
+	const Plane* widest = decoded[0].get();
+	for(const PlaneHandle& plane : decoded)
+	{
+		if(plane->GetWidth() > widest->GetWidth())
+		{
+			widest = plane.get();
+		}
+	}
+	int width = widest->GetWidth();
+	int height = widest->GetHeight();
+	if(job.targetResolution > 0)
+	{
+		height = std::max(1, static_cast<int>(static_cast<int64_t>(height) * job.targetResolution / width));
+		width = job.targetResolution;
+	}
+
+	const unsigned char* planes[3] = { decoded[0]->GetPixels(), decoded[1]->GetPixels(), decoded[2]->GetPixels() };
+	for(int i = 0; i < 3; ++i)
+	{
+		const int decodedWidth = decoded[i]->GetWidth();
+		const int decodedHeight = decoded[i]->GetHeight();
+		if(decodedWidth == width && decodedHeight == height)
+		{
+			continue;
+		}
+
+		resampled[i].resize(static_cast<size_t>(width) * height * sampleBytes);
+		const bool resized = bitDepth == 16
+			? Resampler::Resize(reinterpret_cast<const uint16_t*>(planes[i]), decodedWidth, decodedHeight, 1,
+				reinterpret_cast<uint16_t*>(resampled[i].data()), width, height, job.workerCount)
+			: Resampler::Resize(planes[i], decodedWidth, decodedHeight, 1, resampled[i].data(), width, height, job.workerCount);
+		if(!resized)
+		{
+			std::cerr << "Failed to resample input!\n";
+			freeInputs();
+			return false;
+		}
+
+		// this job no longer needs the decoded plane once its resampled copy exists
+		decoded[i].reset();
+		planes[i] = resampled[i].data();
+	}
+
+	PackSource source{ planes[0], planes[1], planes[2], width, height, bitDepth, dither };
+
+	// Low-memory mode: bands go straight from the packer into the PNG streams, so neither packed
+	// image nor encoded file is ever held whole
+	if(job.streaming)
+	{
+		const bool written = ORMPacker::PackToPng(source, doUnreal ? job.saveUnrealPath : std::string(), doUnity ? job.saveUnityPath : std::string(),
+			job.pngOptions, progressCallback);
+		freeInputs();
+		if(written)
+		{
+			cache.Store();
+		}
+		if(progressCallback)
+		{
+			progressCallback(1.0f);
+		}
+		return written;
+	}
+
+	const size_t count = static_cast<size_t>(width) * height;
+	const float totalSteps = 1.0f + (doUnreal ? 1.0f : 0.0f) + (doUnity ? 1.0f : 0.0f);
+	float currentStep = 0.0f;
+
+	std::vector<unsigned char> ormRGB(doUnreal ? count * 3 * packedBytes : 0);
+	std::vector<unsigned char> ormRGBA(doUnity ? count * 4 * packedBytes : 0);
+
+	PackTarget target{ doUnreal ? ormRGB.data() : nullptr, doUnity ? ormRGBA.data() : nullptr };
+	ORMPacker::Pack(source, target, job.workerCount, [&](float packProgress)
+	{
+		if(progressCallback)
+		{
+			progressCallback((currentStep + packProgress) / totalSteps);
+		}
+	});
+	currentStep += 1.0f;
+
+	freeInputs();
+
+	// The two encodes are independent: the Unity file is written on the pool while this thread writes the Unreal one
+	bool unityWritten = true;
+	std::future<void> unityEncode;
+	const TaskWaiter<void> unityWaiter(unityEncode);
+	if(doUnity)
+	{
+		unityEncode = pool.Submit([&]()
+		{
+			unityWritten = PngWriter::Write(job.saveUnityPath, ormRGBA.data(), width, height, 4, job.pngOptions);
+		});
+	}
+
+	bool unrealWritten = true;
+	if(doUnreal)
+	{
+		unrealWritten = PngWriter::Write(job.saveUnrealPath, ormRGB.data(), width, height, 3, job.pngOptions);
+		currentStep += 1.0f;
+		if(progressCallback)
+		{
+			progressCallback(currentStep / totalSteps);
+		}
+	}
+
+	if(unityEncode.valid())
+	{
+		pool.Wait(unityEncode);
+		unityEncode.get();		// rethrows what the encode threw
+		currentStep += 1.0f;
+		if(progressCallback) progressCallback(currentStep / totalSteps);
+	}
+
+	if(preview)
+	{
+		preview->width = width;
+		preview->height = height;
+		preview->path = doUnreal ? job.saveUnrealPath : job.saveUnityPath;
+		preview->channels = doUnreal ? 3 : 4;
+		preview->layout = doUnreal ? ORMLayout::UnrealRGB : ORMLayout::UnityRGBA;
+		const unsigned char* packed = doUnreal ? ormRGB.data() : ormRGBA.data();
+
+		// the preview is 8-bit; big-endian samples keep their high byte first
+		std::vector<unsigned char> narrowed;
+		if(packedBytes == 2)
+		{
+			narrowed.resize(count * preview->channels);
+			for(size_t i = 0; i < narrowed.size(); ++i)
+			{
+				narrowed[i] = packed[i * 2];
+			}
+			packed = narrowed.data();
+		}
+		preview->levels = BuildPreviewLevels(packed, width, height, preview->channels, previewFitWidth);
+	}
+
+	if(unrealWritten && unityWritten)
+	{
+		cache.Store();
+	}
+
+	if(progressCallback)
+	{
+		progressCallback(1.0f);
+	}
+
+	return unrealWritten && unityWritten;
+}
+
+std::vector<MipLevel> ORMGenerator::BuildPreviewLevels(const unsigned char* pixels, int width, int height, int channels, int fitWidth)
+{
+	// The viewport shows the image fitWidth pixels wide; anything finer is never sampled
+	fitWidth = std::max(1, fitWidth);
+	const int fitHeight = std::max(1, static_cast<int>(static_cast<int64_t>(fitWidth) * height / std::max(1, width)));
+	return MipPyramid::Build(pixels, width, height, channels, fitWidth, fitHeight);
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "Types.h"
+
+/**
+ * ORMGenerator
+ *
+ * The packing engine shared by the desktop UI and the headless CLI: decodes the three
+ * inputs concurrently, resamples them to one size, packs and writes the requested layouts.
+ * Free of any GL/windowing dependency.
+ */
+class ORMGenerator
+{
+public:
+	/**
+	 * Runs one job. When preview is given (and the job is not streaming) it receives the
+	 * packed image as a mip chain fitted to previewFitWidth. Returns false if an input could
+	 * not be read or an output could not be written.
+	 */
+	static bool Generate(const SaveData& job, PreviewImage* preview = nullptr, int previewFitWidth = 0);
+
+	/** Mip chain of a packed image, starting at the smallest level that still covers fitWidth. */
+	static std::vector<MipLevel> BuildPreviewLevels(const unsigned char* pixels, int width, int height, int channels, int fitWidth);
+};
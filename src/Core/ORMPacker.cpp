@@ -0,0 +1,212 @@
+#include "ORMPacker.h"
+#include "PackKernels.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace
+{
+	size_t GetSampleBytes(const PackSource& src)
+	{
+		return src.bitDepth == 16 ? 2 : 1;
+	}
+
+	size_t GetPackedSampleBytes(const PackSource& src)
+	{
+		return src.bitDepth == 16 && !src.dither ? 2 : 1;
+	}
+
+	/** Splits the span at row ends, since the dither phase follows the image position. */
+	void PackRowsDithered(const PackSource& src, size_t first, size_t pixels, uint8_t* unrealRGB, uint8_t* unityRGBA)
+	{
+		const size_t width = static_cast<size_t>(src.width);
+		const uint16_t* ao = reinterpret_cast<const uint16_t*>(src.ao);
+		const uint16_t* rough = reinterpret_cast<const uint16_t*>(src.rough);
+		const uint16_t* metal = reinterpret_cast<const uint16_t*>(src.metal);
+
+		for(size_t done = 0; done < pixels;)
+		{
+			const size_t index = first + done;
+			const size_t x = index % width;
+			const size_t y = index / width;
+			const size_t run = std::min(pixels - done, width - x);
+			if(unrealRGB && unityRGBA)
+			{
+				PackKernels::PackFusedDithered(ao + index, rough + index, metal + index, unrealRGB + done * 3, unityRGBA + done * 4, run, x, y);
+			}
+			else if(unrealRGB)
+			{
+				PackKernels::PackUnrealRGBDithered(ao + index, rough + index, metal + index, unrealRGB + done * 3, run, x, y);
+			}
+			else
+			{
+				PackKernels::PackUnityRGBADithered(ao + index, rough + index, metal + index, unityRGBA + done * 4, run, x, y);
+			}
+			done += run;
+		}
+	}
+
+	void PackRows16(const PackSource& src, size_t first, size_t pixels, uint8_t* unrealRGB, uint8_t* unityRGBA)
+	{
+		const uint16_t* ao = reinterpret_cast<const uint16_t*>(src.ao) + first;
+		const uint16_t* rough = reinterpret_cast<const uint16_t*>(src.rough) + first;
+		const uint16_t* metal = reinterpret_cast<const uint16_t*>(src.metal) + first;
+		if(unrealRGB && unityRGBA)
+		{
+			PackKernels::PackFused16(ao, rough, metal, unrealRGB, unityRGBA, pixels);
+		}
+		else if(unrealRGB)
+		{
+			PackKernels::PackUnrealRGB16(ao, rough, metal, unrealRGB, pixels);
+		}
+		else
+		{
+			PackKernels::PackUnityRGBA16(ao, rough, metal, unityRGBA, pixels);
+		}
+	}
+
+	void PackRows(const PackSource& src, size_t first, size_t pixels, uint8_t* unrealRGB, uint8_t* unityRGBA)
+	{
+		if(src.bitDepth == 16 && src.dither)
+		{
+			PackRowsDithered(src, first, pixels, unrealRGB, unityRGBA);
+		}
+		else if(src.bitDepth == 16)
+		{
+			PackRows16(src, first, pixels, unrealRGB, unityRGBA);
+		}
+		else if(unrealRGB && unityRGBA)
+		{
+			PackKernels::PackFused(src.ao + first, src.rough + first, src.metal + first, unrealRGB, unityRGBA, pixels);
+		}
+		else if(unrealRGB)
+		{
+			PackKernels::PackUnrealRGB(src.ao + first, src.rough + first, src.metal + first, unrealRGB, pixels);
+		}
+		else
+		{
+			PackKernels::PackUnityRGBA(src.ao + first, src.rough + first, src.metal + first, unityRGBA, pixels);
+		}
+	}
+}
+
+void ORMPacker::Pack(const PackSource& src, const PackTarget& dst, unsigned int workerCount,
+	const std::function<void(float)>& progress)
+{
+	if(src.width <= 0 || src.height <= 0 || (!dst.unrealRGB && !dst.unityRGBA))
+	{
+		return;
+	}
+
+	const size_t width = static_cast<size_t>(src.width);
+	const size_t height = static_cast<size_t>(src.height);
+	const size_t packedBytes = GetPackedSampleBytes(src);
+	const size_t bandRows = std::max<size_t>(1, BandPixels / GetSampleBytes(src) / width);
+	const size_t bandCount = (height + bandRows - 1) / bandRows;
+
+	std::atomic<size_t> finishedBands{0};
+
+	ThreadPool::Get().ParallelFor(bandCount, [&](size_t band)
+	{
+		const size_t first = band * bandRows * width;
+		const size_t pixels = std::min(bandRows, height - band * bandRows) * width;
+
+		PackRows(src, first, pixels,
+			dst.unrealRGB ? dst.unrealRGB + first * 3 * packedBytes : nullptr,
+			dst.unityRGBA ? dst.unityRGBA + first * 4 * packedBytes : nullptr);
+
+		const size_t finished = ++finishedBands;
+		if(progress)
+		{
+			progress(static_cast<float>(finished) / bandCount);
+		}
+	}, workerCount);
+}
+
+bool ORMPacker::PackToPng(const PackSource& src, const std::string& unrealPath, const std::string& unityPath,
+	const PngWriteOptions& options, const std::function<void(float)>& progress)
+{
+	if(src.width <= 0 || src.height <= 0 || (unrealPath.empty() && unityPath.empty()))
+	{
+		return false;
+	}
+
+	PngWriteOptions fileOptions = options;
+	fileOptions.bitDepth = GetPackedSampleBytes(src) == 2 ? 16 : 8;
+
+	std::unique_ptr<PngStreamWriter> unrealWriter;
+	std::unique_ptr<PngStreamWriter> unityWriter;
+	if(!unrealPath.empty())
+	{
+		unrealWriter = std::make_unique<PngStreamWriter>(unrealPath, src.width, src.height, 3, fileOptions);
+	}
+	if(!unityPath.empty())
+	{
+		unityWriter = std::make_unique<PngStreamWriter>(unityPath, src.width, src.height, 4, fileOptions);
+	}
+	if((unrealWriter && !unrealWriter->IsOpen()) || (unityWriter && !unityWriter->IsOpen()))
+	{
+		return false;
+	}
+
+	// one band partition for both files, sized by the wider row
+	const PngBandEncoder& widest = unityWriter ? unityWriter->GetEncoder() : unrealWriter->GetEncoder();
+	const size_t width = static_cast<size_t>(src.width);
+	const size_t height = static_cast<size_t>(src.height);
+	const size_t packedBytes = GetPackedSampleBytes(src);
+	const size_t bandRows = widest.GetBandRows();
+	const size_t bandCount = (height + bandRows - 1) / bandRows;
+
+	std::atomic<size_t> finishedBands{0};
+
+	// ParallelFor hands out bands in order, so at most one band per thread is in flight and the
+	// stream writers only ever hold the few bands that finished ahead of a slower neighbour
+	ThreadPool::Get().ParallelFor(bandCount, [&](size_t band)
+	{
+		const size_t firstRow = band * bandRows;
+		const size_t rowCount = std::min(bandRows, height - firstRow);
+		const size_t unrealContext = unrealWriter ? unrealWriter->GetEncoder().GetContextRows(firstRow) : 0;
+		const size_t unityContext = unityWriter ? unityWriter->GetEncoder().GetContextRows(firstRow) : 0;
+		const size_t contextRows = std::max(unrealContext, unityContext);
+		const size_t packedRows = contextRows + rowCount;
+
+		const size_t unrealRowBytes = width * 3 * packedBytes;
+		const size_t unityRowBytes = width * 4 * packedBytes;
+		std::vector<uint8_t> unrealRows(unrealWriter ? packedRows * unrealRowBytes : 0);
+		std::vector<uint8_t> unityRows(unityWriter ? packedRows * unityRowBytes : 0);
+		PackRows(src, (firstRow - contextRows) * width, packedRows * width,
+			unrealWriter ? unrealRows.data() : nullptr,
+			unityWriter ? unityRows.data() : nullptr);
+
+		if(unrealWriter)
+		{
+			const uint8_t* rows = unrealRows.data() + (contextRows - unrealContext) * unrealRowBytes;
+			unrealWriter->Commit(band, unrealWriter->GetEncoder().Encode(rows, firstRow, rowCount));
+		}
+		if(unityWriter)
+		{
+			const uint8_t* rows = unityRows.data() + (contextRows - unityContext) * unityRowBytes;
+			unityWriter->Commit(band, unityWriter->GetEncoder().Encode(rows, firstRow, rowCount));
+		}
+
+		const size_t finished = ++finishedBands;
+		if(progress)
+		{
+			progress(static_cast<float>(finished) / bandCount);
+		}
+	}, fileOptions.workerCount);
+
+	bool written = true;
+	if(unrealWriter)
+	{
+		written = unrealWriter->Finish() && written;
+	}
+	if(unityWriter)
+	{
+		written = unityWriter->Finish() && written;
+	}
+	return written;
+}
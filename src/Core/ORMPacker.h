@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+#include "PngWriter.h"
+
+/** Three decoded grayscale planes of identical size. */
+struct PackSource
+{
+	const uint8_t* ao = nullptr;	// uint16_t samples in host order when bitDepth is 16
+	const uint8_t* rough = nullptr;
+	const uint8_t* metal = nullptr;
+	int width = 0;
+	int height = 0;
+	int bitDepth = 8;				// 8 or 16; packed samples have the same depth unless dithered
+	bool dither = false;			// 16-bit planes packed into 8-bit samples with an ordered dither
+};
+
+/** Output buffers; a null pointer skips that layout. 16-bit samples are stored big-endian, ready for PngWriter. */
+struct PackTarget
+{
+	uint8_t* unrealRGB = nullptr;	// width * height * 3 samples
+	uint8_t* unityRGBA = nullptr;	// width * height * 4 samples
+};
+
+/**
+ * ORMPacker
+ *
+ * Splits the image into row bands sized to stay cache resident and packs them in
+ * parallel on the shared ThreadPool through PackKernels. When both layouts are
+ * requested every band is packed with the fused kernel. Dithering down from 16 bits
+ * happens inside the same kernels, so it costs no extra pass over the image.
+ *
+ * PackToPng streams the same bands straight into PngStreamWriter, so the packed images
+ * and the encoded files never exist in memory as a whole.
+ */
+class ORMPacker
+{
+public:
+	/** Target number of pixels per band (64 KiB per input plane). */
+	static constexpr size_t BandPixels = 64 * 1024;
+
+	/**
+	 * Packs the whole image. At most workerCount threads (including the caller, 0 = the whole pool)
+	 * work on the bands; progress receives the fraction of finished bands and may be invoked from any worker.
+	 */
+	static void Pack(const PackSource& src, const PackTarget& dst, unsigned int workerCount = 0,
+		const std::function<void(float)>& progress = nullptr);
+
+	/**
+	 * Packs and encodes band by band into the given PNG files; an empty path skips that layout.
+	 * The files take the packed bit depth of src, whatever options.bitDepth says.
+	 * Only a few bands per worker are resident at a time. Returns false if a file could not be written.
+	 */
+	static bool PackToPng(const PackSource& src, const std::string& unrealPath, const std::string& unityPath,
+		const PngWriteOptions& options = {}, const std::function<void(float)>& progress = nullptr);
+};
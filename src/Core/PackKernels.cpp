@@ -0,0 +1,839 @@
+#include "PackKernels.h"
+#include "CpuFeatures.h"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+	#define ORM_PACK_X86 1
+	#include <immintrin.h>
+#endif
+
+#if defined(ORM_PACK_X86) && (defined(__GNUC__) || defined(__clang__))
+	#define ORM_TARGET_SSE2 __attribute__((target("sse2")))
+	#define ORM_TARGET_SSSE3 __attribute__((target("ssse3")))
+	#define ORM_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+	#define ORM_TARGET_SSE2
+	#define ORM_TARGET_SSSE3
+	#define ORM_TARGET_AVX2
+#endif
+
+namespace
+{
+	using PackFn = void (*)(const uint8_t*, const uint8_t*, const uint8_t*, uint8_t*, size_t);
+	using PackFusedFn = void (*)(const uint8_t*, const uint8_t*, const uint8_t*, uint8_t*, uint8_t*, size_t);
+	using Pack16Fn = void (*)(const uint16_t*, const uint16_t*, const uint16_t*, uint8_t*, size_t);
+	using PackFused16Fn = void (*)(const uint16_t*, const uint16_t*, const uint16_t*, uint8_t*, uint8_t*, size_t);
+	using PackDitheredFn = void (*)(const uint16_t*, const uint16_t*, const uint16_t*, const uint8_t*, uint8_t*, size_t);
+	using PackFusedDitheredFn = void (*)(const uint16_t*, const uint16_t*, const uint16_t*, const uint8_t*, uint8_t*, uint8_t*, size_t);
+
+	void PackUnrealRGBScalar(const uint8_t* ao, const uint8_t* rough, const uint8_t* metal, uint8_t* dst, size_t count)
+	{
+		for(size_t i = 0; i < count; ++i)
+		{
+			dst[i * 3 + 0] = ao[i];
+			dst[i * 3 + 1] = rough[i];
+			dst[i * 3 + 2] = metal[i];
+		}
+	}
+
+	void PackUnityRGBAScalar(const uint8_t* ao, const uint8_t* rough, const uint8_t* metal, uint8_t* dst, size_t count)
+	{
+		for(size_t i = 0; i < count; ++i)
+		{
+			dst[i * 4 + 0] = metal[i];
+			dst[i * 4 + 1] = ao[i];
+			dst[i * 4 + 2] = 255;
+			dst[i * 4 + 3] = static_cast<uint8_t>(255 - rough[i]);
+		}
+	}
+
+	void PackFusedScalar(const uint8_t* ao, const uint8_t* rough, const uint8_t* metal, uint8_t* dstRGB, uint8_t* dstRGBA, size_t count)
+	{
+		for(size_t i = 0; i < count; ++i)
+		{
+			const uint8_t a = ao[i];
+			const uint8_t r = rough[i];
+			const uint8_t m = metal[i];
+
+			dstRGB[i * 3 + 0] = a;
+			dstRGB[i * 3 + 1] = r;
+			dstRGB[i * 3 + 2] = m;
+
+			dstRGBA[i * 4 + 0] = m;
+			dstRGBA[i * 4 + 1] = a;
+			dstRGBA[i * 4 + 2] = 255;
+			dstRGBA[i * 4 + 3] = static_cast<uint8_t>(255 - r);
+		}
+	}
+
+	inline void StoreBigEndian(uint8_t* dst, uint16_t value)
+	{
+		dst[0] = static_cast<uint8_t>(value >> 8);
+		dst[1] = static_cast<uint8_t>(value);
+	}
+
+	void PackUnrealRGB16Scalar(const uint16_t* ao, const uint16_t* rough, const uint16_t* metal, uint8_t* dst, size_t count)
+	{
+		for(size_t i = 0; i < count; ++i)
+		{
+			StoreBigEndian(dst + i * 6 + 0, ao[i]);
+			StoreBigEndian(dst + i * 6 + 2, rough[i]);
+			StoreBigEndian(dst + i * 6 + 4, metal[i]);
+		}
+	}
+
+	void PackUnityRGBA16Scalar(const uint16_t* ao, const uint16_t* rough, const uint16_t* metal, uint8_t* dst, size_t count)
+	{
+		for(size_t i = 0; i < count; ++i)
+		{
+			StoreBigEndian(dst + i * 8 + 0, metal[i]);
+			StoreBigEndian(dst + i * 8 + 2, ao[i]);
+			StoreBigEndian(dst + i * 8 + 4, 65535);
+			StoreBigEndian(dst + i * 8 + 6, static_cast<uint16_t>(65535 - rough[i]));
+		}
+	}
+
+	void PackFused16Scalar(const uint16_t* ao, const uint16_t* rough, const uint16_t* metal, uint8_t* dstRGB, uint8_t* dstRGBA, size_t count)
+	{
+		PackUnrealRGB16Scalar(ao, rough, metal, dstRGB, count);
+		PackUnityRGBA16Scalar(ao, rough, metal, dstRGBA, count);
+	}
+
+	/**
+	 * 16x16 Bayer matrix of dither offsets 0-255: bit-reversed interleave of (x ^ y) and y, so
+	 * every 2^k x 2^k block spreads its offsets evenly.
+	 */
+	struct BayerMatrix
+	{
+		uint8_t thresholds[16][16] = {};
+
+		constexpr BayerMatrix()
+		{
+			for(int y = 0; y < 16; ++y)
+			{
+				for(int x = 0; x < 16; ++x)
+				{
+					int value = 0;
+					for(int bit = 0; bit < 4; ++bit)
+					{
+						value |= (((x ^ y) >> bit) & 1) << (7 - 2 * bit);
+						value |= ((y >> bit) & 1) << (6 - 2 * bit);
+					}
+					thresholds[y][x] = static_cast<uint8_t>(value);
+				}
+			}
+		}
+	};
+
+	constexpr BayerMatrix Bayer;
+
+	/**
+	 * v / 257 (the 16 to 8-bit scale) rounded by the dither offset: v - v / 256 approximates
+	 * v * 255 / 256, the offset fills the byte that is dropped. Never exceeds 65535, and
+	 * v = 257 * k maps to 256 * k, so widened 8-bit samples return k for every offset.
+	 */
+	inline uint8_t DitherSample(uint16_t v, uint8_t threshold)
+	{
+		return static_cast<uint8_t>((v - (v >> 8) + threshold) >> 8);
+	}
+
+	/** Dithered kernels take the 16 offsets of their row, rotated so thresholds[0] belongs to the first pixel. */
+	void PackUnrealRGBDitheredScalar(const uint16_t* ao, const uint16_t* rough, const uint16_t* metal, const uint8_t* thresholds,
+		uint8_t* dst, size_t count)
+	{
+		for(size_t i = 0; i < count; ++i)
+		{
+			const uint8_t t = thresholds[i & 15];
+			dst[i * 3 + 0] = DitherSample(ao[i], t);
+			dst[i * 3 + 1] = DitherSample(rough[i], t);
+			dst[i * 3 + 2] = DitherSample(metal[i], t);
+		}
+	}
+
+	void PackUnityRGBADitheredScalar(const uint16_t* ao, const uint16_t* rough, const uint16_t* metal, const uint8_t* thresholds,
+		uint8_t* dst, size_t count)
+	{
+		for(size_t i = 0; i < count; ++i)
+		{
+			const uint8_t t = thresholds[i & 15];
+			dst[i * 4 + 0] = DitherSample(metal[i], t);
+			dst[i * 4 + 1] = DitherSample(ao[i], t);
+			dst[i * 4 + 2] = 255;
+			dst[i * 4 + 3] = static_cast<uint8_t>(255 - DitherSample(rough[i], t));
+		}
+	}
+
+	void PackFusedDitheredScalar(const uint16_t* ao, const uint16_t* rough, const uint16_t* metal, const uint8_t* thresholds,
+		uint8_t* dstRGB, uint8_t* dstRGBA, size_t count)
+	{
+		PackUnrealRGBDitheredScalar(ao, rough, metal, thresholds, dstRGB, count);
+		PackUnityRGBADitheredScalar(ao, rough, metal, thresholds, dstRGBA, count);
+	}
+
+#if defined(ORM_PACK_X86)
+	/**
+	 * pshufb masks that scatter one register of a plane into three 16-byte chunks of
+	 * interleaved RGB. For 8-bit samples, chunk c, plane p: byte k takes pixel (16c + k) / 3
+	 * when (16c + k) % 3 == p, otherwise it is zeroed (0x80). For 16-bit samples the same
+	 * holds per 2-byte sample, with the two bytes swapped into big-endian order.
+	 */
+	struct InterleaveMasks3
+	{
+		alignas(16) uint8_t bytes[3][3][16] = {};
+
+		constexpr explicit InterleaveMasks3(int sampleBytes)
+		{
+			for(int chunk = 0; chunk < 3; ++chunk)
+			{
+				for(int plane = 0; plane < 3; ++plane)
+				{
+					for(int k = 0; k < 16; ++k)
+					{
+						const int j = (chunk * 16 + k) / sampleBytes;
+						const int byte = sampleBytes - 1 - (chunk * 16 + k) % sampleBytes;
+						bytes[chunk][plane][k] = (j % 3 == plane) ? static_cast<uint8_t>(j / 3 * sampleBytes + byte) : 0x80;
+					}
+				}
+			}
+		}
+	};
+
+	constexpr InterleaveMasks3 RGBMasks(1);
+	constexpr InterleaveMasks3 RGBMasks16(2);
+
+	struct ShuffleRGB128
+	{
+		__m128i m[3][3];
+	};
+
+	struct ShuffleRGB256
+	{
+		__m256i m[3][3];
+	};
+
+	ORM_TARGET_SSSE3 inline ShuffleRGB128 LoadShuffleRGB128(const InterleaveMasks3& source = RGBMasks)
+	{
+		ShuffleRGB128 masks;
+		for(int chunk = 0; chunk < 3; ++chunk)
+		{
+			for(int plane = 0; plane < 3; ++plane)
+			{
+				masks.m[chunk][plane] = _mm_load_si128(reinterpret_cast<const __m128i*>(source.bytes[chunk][plane]));
+			}
+		}
+		return masks;
+	}
+
+	ORM_TARGET_AVX2 inline ShuffleRGB256 LoadShuffleRGB256(const InterleaveMasks3& source = RGBMasks)
+	{
+		ShuffleRGB256 masks;
+		for(int chunk = 0; chunk < 3; ++chunk)
+		{
+			for(int plane = 0; plane < 3; ++plane)
+			{
+				masks.m[chunk][plane] = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(source.bytes[chunk][plane])));
+			}
+		}
+		return masks;
+	}
+
+	/** Writes 16 RGB pixels (48 bytes), or 8 with the 16-bit masks. */
+	ORM_TARGET_SSSE3 inline void StoreRGB16(uint8_t* dst, __m128i r, __m128i g, __m128i b, const ShuffleRGB128& s)
+	{
+		__m128i* out = reinterpret_cast<__m128i*>(dst);
+		for(int chunk = 0; chunk < 3; ++chunk)
+		{
+			const __m128i rg = _mm_or_si128(_mm_shuffle_epi8(r, s.m[chunk][0]), _mm_shuffle_epi8(g, s.m[chunk][1]));
+			_mm_storeu_si128(out + chunk, _mm_or_si128(rg, _mm_shuffle_epi8(b, s.m[chunk][2])));
+		}
+	}
+
+	/**
+	 * Writes 32 RGB pixels (96 bytes), or 16 with the 16-bit masks. pshufb works per 128-bit lane, so each lane produces
+	 * 48 bytes of its own 16 pixels; the three results are recombined across lanes before storing.
+	 */
+	ORM_TARGET_AVX2 inline void StoreRGB32(uint8_t* dst, __m256i r, __m256i g, __m256i b, const ShuffleRGB256& s)
+	{
+		__m256i c[3];
+		for(int chunk = 0; chunk < 3; ++chunk)
+		{
+			const __m256i rg = _mm256_or_si256(_mm256_shuffle_epi8(r, s.m[chunk][0]), _mm256_shuffle_epi8(g, s.m[chunk][1]));
+			c[chunk] = _mm256_or_si256(rg, _mm256_shuffle_epi8(b, s.m[chunk][2]));
+		}
+
+		__m256i* out = reinterpret_cast<__m256i*>(dst);
+		_mm256_storeu_si256(out + 0, _mm256_permute2x128_si256(c[0], c[1], 0x20));
+		_mm256_storeu_si256(out + 1, _mm256_permute2x128_si256(c[2], c[0], 0x30));
+		_mm256_storeu_si256(out + 2, _mm256_permute2x128_si256(c[1], c[2], 0x31));
+	}
+
+	/**
+	 * Writes 16 Unity RGBA pixels (64 bytes). Roughness is inverted with a single XOR against
+	 * the all-ones register, which doubles as the constant white lane: byte unpacks build (M, A)
+	 * and (255, 255 - R) pairs, a 16-bit unpack then merges them into RGBA quads.
+	 */
+	ORM_TARGET_SSE2 inline void StoreUnityRGBA16(uint8_t* dst, __m128i a, __m128i r, __m128i m, __m128i ones)
+	{
+		const __m128i inv = _mm_xor_si128(r, ones);
+		const __m128i maLo = _mm_unpacklo_epi8(m, a);
+		const __m128i maHi = _mm_unpackhi_epi8(m, a);
+		const __m128i wiLo = _mm_unpacklo_epi8(ones, inv);
+		const __m128i wiHi = _mm_unpackhi_epi8(ones, inv);
+
+		__m128i* out = reinterpret_cast<__m128i*>(dst);
+		_mm_storeu_si128(out + 0, _mm_unpacklo_epi16(maLo, wiLo));
+		_mm_storeu_si128(out + 1, _mm_unpackhi_epi16(maLo, wiLo));
+		_mm_storeu_si128(out + 2, _mm_unpacklo_epi16(maHi, wiHi));
+		_mm_storeu_si128(out + 3, _mm_unpackhi_epi16(maHi, wiHi));
+	}
+
+	/** Writes 32 Unity RGBA pixels (128 bytes); same unpack network, lanes reordered before storing. */
+	ORM_TARGET_AVX2 inline void StoreUnityRGBA32(uint8_t* dst, __m256i a, __m256i r, __m256i m, __m256i ones)
+	{
+		const __m256i inv = _mm256_xor_si256(r, ones);
+		const __m256i maLo = _mm256_unpacklo_epi8(m, a);
+		const __m256i maHi = _mm256_unpackhi_epi8(m, a);
+		const __m256i wiLo = _mm256_unpacklo_epi8(ones, inv);
+		const __m256i wiHi = _mm256_unpackhi_epi8(ones, inv);
+
+		const __m256i q0 = _mm256_unpacklo_epi16(maLo, wiLo);
+		const __m256i q1 = _mm256_unpackhi_epi16(maLo, wiLo);
+		const __m256i q2 = _mm256_unpacklo_epi16(maHi, wiHi);
+		const __m256i q3 = _mm256_unpackhi_epi16(maHi, wiHi);
+
+		__m256i* out = reinterpret_cast<__m256i*>(dst);
+		_mm256_storeu_si256(out + 0, _mm256_permute2x128_si256(q0, q1, 0x20));
+		_mm256_storeu_si256(out + 1, _mm256_permute2x128_si256(q2, q3, 0x20));
+		_mm256_storeu_si256(out + 2, _mm256_permute2x128_si256(q0, q1, 0x31));
+		_mm256_storeu_si256(out + 3, _mm256_permute2x128_si256(q2, q3, 0x31));
+	}
+
+	/**
+	 * Writes 8 Unity RGBA pixels of 16-bit samples (64 bytes): the 8-bit network one level up,
+	 * 16-bit unpacks build (M, A) and (65535, 65535 - R) pairs and 32-bit unpacks merge them.
+	 * Samples arrive already swapped to big-endian; the inversion does not care about byte order.
+	 */
+	ORM_TARGET_SSE2 inline void StoreUnityRGBA16x8(uint8_t* dst, __m128i a, __m128i r, __m128i m, __m128i ones)
+	{
+		const __m128i inv = _mm_xor_si128(r, ones);
+		const __m128i maLo = _mm_unpacklo_epi16(m, a);
+		const __m128i maHi = _mm_unpackhi_epi16(m, a);
+		const __m128i wiLo = _mm_unpacklo_epi16(ones, inv);
+		const __m128i wiHi = _mm_unpackhi_epi16(ones, inv);
+
+		__m128i* out = reinterpret_cast<__m128i*>(dst);
+		_mm_storeu_si128(out + 0, _mm_unpacklo_epi32(maLo, wiLo));
+		_mm_storeu_si128(out + 1, _mm_unpackhi_epi32(maLo, wiLo));
+		_mm_storeu_si128(out + 2, _mm_unpacklo_epi32(maHi, wiHi));
+		_mm_storeu_si128(out + 3, _mm_unpackhi_epi32(maHi, wiHi));
+	}
+
+	/** Writes 16 Unity RGBA pixels of 16-bit samples (128 bytes); lanes reordered like StoreUnityRGBA32. */
+	ORM_TARGET_AVX2 inline void StoreUnityRGBA16x16(uint8_t* dst, __m256i a, __m256i r, __m256i m, __m256i ones)
+	{
+		const __m256i inv = _mm256_xor_si256(r, ones);
+		const __m256i maLo = _mm256_unpacklo_epi16(m, a);
+		const __m256i maHi = _mm256_unpackhi_epi16(m, a);
+		const __m256i wiLo = _mm256_unpacklo_epi16(ones, inv);
+		const __m256i wiHi = _mm256_unpackhi_epi16(ones, inv);
+
+		const __m256i q0 = _mm256_unpacklo_epi32(maLo, wiLo);
+		const __m256i q1 = _mm256_unpackhi_epi32(maLo, wiLo);
+		const __m256i q2 = _mm256_unpacklo_epi32(maHi, wiHi);
+		const __m256i q3 = _mm256_unpackhi_epi32(maHi, wiHi);
+
+		__m256i* out = reinterpret_cast<__m256i*>(dst);
+		_mm256_storeu_si256(out + 0, _mm256_permute2x128_si256(q0, q1, 0x20));
+		_mm256_storeu_si256(out + 1, _mm256_permute2x128_si256(q2, q3, 0x20));
+		_mm256_storeu_si256(out + 2, _mm256_permute2x128_si256(q0, q1, 0x31));
+		_mm256_storeu_si256(out + 3, _mm256_permute2x128_si256(q2, q3, 0x31));
+	}
+
+	ORM_TARGET_SSE2 inline __m128i SwapBytes16(__m128i x)
+	{
+		return _mm_or_si128(_mm_slli_epi16(x, 8), _mm_srli_epi16(x, 8));
+	}
+
+	ORM_TARGET_AVX2 inline __m256i SwapBytes16(__m256i x)
+	{
+		return _mm256_or_si256(_mm256_slli_epi16(x, 8), _mm256_srli_epi16(x, 8));
+	}
+
+	ORM_TARGET_SSE2 inline __m128i Load16(const uint8_t* src)
+	{
+		return _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+	}
+
+	ORM_TARGET_AVX2 inline __m256i Load32(const uint8_t* src)
+	{
+		return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src));
+	}
+
+	ORM_TARGET_SSSE3 void PackUnrealRGBSSSE3(const uint8_t* ao, const uint8_t* rough, const uint8_t* metal, uint8_t* dst, size_t count)
+	{
+		const ShuffleRGB128 masks = LoadShuffleRGB128();
+
+		size_t i = 0;
+		for(; i + 16 <= count; i += 16)
+		{
+			StoreRGB16(dst + i * 3, Load16(ao + i), Load16(rough + i), Load16(metal + i), masks);
+		}
+
+		PackUnrealRGBScalar(ao + i, rough + i, metal + i, dst + i * 3, count - i);
+	}
+
+	ORM_TARGET_AVX2 void PackUnrealRGBAVX2(const uint8_t* ao, const uint8_t* rough, const uint8_t* metal, uint8_t* dst, size_t count)
+	{
+		const ShuffleRGB256 masks = LoadShuffleRGB256();
+
+		size_t i = 0;
+		for(; i + 32 <= count; i += 32)
+		{
+			StoreRGB32(dst + i * 3, Load32(ao + i), Load32(rough + i), Load32(metal + i), masks);
+		}
+
+		PackUnrealRGBSSSE3(ao + i, rough + i, metal + i, dst + i * 3, count - i);
+	}
+
+	ORM_TARGET_SSE2 void PackUnityRGBASSE2(const uint8_t* ao, const uint8_t* rough, const uint8_t* metal, uint8_t* dst, size_t count)
+	{
+		const __m128i ones = _mm_set1_epi8(static_cast<char>(0xFF));
+
+		size_t i = 0;
+		for(; i + 16 <= count; i += 16)
+		{
+			StoreUnityRGBA16(dst + i * 4, Load16(ao + i), Load16(rough + i), Load16(metal + i), ones);
+		}
+
+		PackUnityRGBAScalar(ao + i, rough + i, metal + i, dst + i * 4, count - i);
+	}
+
+	ORM_TARGET_AVX2 void PackUnityRGBAAVX2(const uint8_t* ao, const uint8_t* rough, const uint8_t* metal, uint8_t* dst, size_t count)
+	{
+		const __m256i ones = _mm256_set1_epi8(static_cast<char>(0xFF));
+
+		size_t i = 0;
+		for(; i + 32 <= count; i += 32)
+		{
+			StoreUnityRGBA32(dst + i * 4, Load32(ao + i), Load32(rough + i), Load32(metal + i), ones);
+		}
+
+		PackUnityRGBASSE2(ao + i, rough + i, metal + i, dst + i * 4, count - i);
+	}
+
+	/** Both layouts from one load of the input registers. */
+	ORM_TARGET_SSSE3 void PackFusedSSSE3(const uint8_t* ao, const uint8_t* rough, const uint8_t* metal, uint8_t* dstRGB, uint8_t* dstRGBA, size_t count)
+	{
+		const ShuffleRGB128 masks = LoadShuffleRGB128();
+		const __m128i ones = _mm_set1_epi8(static_cast<char>(0xFF));
+
+		size_t i = 0;
+		for(; i + 16 <= count; i += 16)
+		{
+			const __m128i a = Load16(ao + i);
+			const __m128i r = Load16(rough + i);
+			const __m128i m = Load16(metal + i);
+			StoreRGB16(dstRGB + i * 3, a, r, m, masks);
+			StoreUnityRGBA16(dstRGBA + i * 4, a, r, m, ones);
+		}
+
+		PackFusedScalar(ao + i, rough + i, metal + i, dstRGB + i * 3, dstRGBA + i * 4, count - i);
+	}
+
+	ORM_TARGET_AVX2 void PackFusedAVX2(const uint8_t* ao, const uint8_t* rough, const uint8_t* metal, uint8_t* dstRGB, uint8_t* dstRGBA, size_t count)
+	{
+		const ShuffleRGB256 masks = LoadShuffleRGB256();
+		const __m256i ones = _mm256_set1_epi8(static_cast<char>(0xFF));
+
+		size_t i = 0;
+		for(; i + 32 <= count; i += 32)
+		{
+			const __m256i a = Load32(ao + i);
+			const __m256i r = Load32(rough + i);
+			const __m256i m = Load32(metal + i);
+			StoreRGB32(dstRGB + i * 3, a, r, m, masks);
+			StoreUnityRGBA32(dstRGBA + i * 4, a, r, m, ones);
+		}
+
+		PackFusedSSSE3(ao + i, rough + i, metal + i, dstRGB + i * 3, dstRGBA + i * 4, count - i);
+	}
+
+	ORM_TARGET_SSE2 inline __m128i Load8x16(const uint16_t* src)
+	{
+		return _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+	}
+
+	ORM_TARGET_AVX2 inline __m256i Load16x16(const uint16_t* src)
+	{
+		return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src));
+	}
+
+	ORM_TARGET_SSSE3 void PackUnrealRGB16SSSE3(const uint16_t* ao, const uint16_t* rough, const uint16_t* metal, uint8_t* dst, size_t count)
+	{
+		// the 16-bit masks swap every sample to big-endian while they interleave
+		const ShuffleRGB128 masks = LoadShuffleRGB128(RGBMasks16);
+
+		size_t i = 0;
+		for(; i + 8 <= count; i += 8)
+		{
+			StoreRGB16(dst + i * 6, Load8x16(ao + i), Load8x16(rough + i), Load8x16(metal + i), masks);
+		}
+
+		PackUnrealRGB16Scalar(ao + i, rough + i, metal + i, dst + i * 6, count - i);
+	}
+
+	ORM_TARGET_AVX2 void PackUnrealRGB16AVX2(const uint16_t* ao, const uint16_t* rough, const uint16_t* metal, uint8_t* dst, size_t count)
+	{
+		const ShuffleRGB256 masks = LoadShuffleRGB256(RGBMasks16);
+
+		size_t i = 0;
+		for(; i + 16 <= count; i += 16)
+		{
+			StoreRGB32(dst + i * 6, Load16x16(ao + i), Load16x16(rough + i), Load16x16(metal + i), masks);
+		}
+
+		PackUnrealRGB16SSSE3(ao + i, rough + i, metal + i, dst + i * 6, count - i);
+	}
+
+	ORM_TARGET_SSE2 void PackUnityRGBA16SSE2(const uint16_t* ao, const uint16_t* rough, const uint16_t* metal, uint8_t* dst, size_t count)
+	{
+		const __m128i ones = _mm_set1_epi8(static_cast<char>(0xFF));
+
+		size_t i = 0;
+		for(; i + 8 <= count; i += 8)
+		{
+			StoreUnityRGBA16x8(dst + i * 8, SwapBytes16(Load8x16(ao + i)), SwapBytes16(Load8x16(rough + i)), SwapBytes16(Load8x16(metal + i)), ones);
+		}
+
+		PackUnityRGBA16Scalar(ao + i, rough + i, metal + i, dst + i * 8, count - i);
+	}
+
+	ORM_TARGET_AVX2 void PackUnityRGBA16AVX2(const uint16_t* ao, const uint16_t* rough, const uint16_t* metal, uint8_t* dst, size_t count)
+	{
+		const __m256i ones = _mm256_set1_epi8(static_cast<char>(0xFF));
+
+		size_t i = 0;
+		for(; i + 16 <= count; i += 16)
+		{
+			StoreUnityRGBA16x16(dst + i * 8, SwapBytes16(Load16x16(ao + i)), SwapBytes16(Load16x16(rough + i)), SwapBytes16(Load16x16(metal + i)), ones);
+		}
+
+		PackUnityRGBA16SSE2(ao + i, rough + i, metal + i, dst + i * 8, count - i);
+	}
+
+	ORM_TARGET_SSSE3 void PackFused16SSSE3(const uint16_t* ao, const uint16_t* rough, const uint16_t* metal, uint8_t* dstRGB, uint8_t* dstRGBA, size_t count)
+	{
+		const ShuffleRGB128 masks = LoadShuffleRGB128(RGBMasks16);
+		const __m128i ones = _mm_set1_epi8(static_cast<char>(0xFF));
+
+		size_t i = 0;
+		for(; i + 8 <= count; i += 8)
+		{
+			const __m128i a = Load8x16(ao + i);
+			const __m128i r = Load8x16(rough + i);
+			const __m128i m = Load8x16(metal + i);
+			StoreRGB16(dstRGB + i * 6, a, r, m, masks);
+			StoreUnityRGBA16x8(dstRGBA + i * 8, SwapBytes16(a), SwapBytes16(r), SwapBytes16(m), ones);
+		}
+
+		PackFused16Scalar(ao + i, rough + i, metal + i, dstRGB + i * 6, dstRGBA + i * 8, count - i);
+	}
+
+	ORM_TARGET_AVX2 void PackFused16AVX2(const uint16_t* ao, const uint16_t* rough, const uint16_t* metal, uint8_t* dstRGB, uint8_t* dstRGBA, size_t count)
+	{
+		const ShuffleRGB256 masks = LoadShuffleRGB256(RGBMasks16);
+		const __m256i ones = _mm256_set1_epi8(static_cast<char>(0xFF));
+
+		size_t i = 0;
+		for(; i + 16 <= count; i += 16)
+		{
+			const __m256i a = Load16x16(ao + i);
+			const __m256i r = Load16x16(rough + i);
+			const __m256i m = Load16x16(metal + i);
+			StoreRGB32(dstRGB + i * 6, a, r, m, masks);
+			StoreUnityRGBA16x16(dstRGBA + i * 8, SwapBytes16(a), SwapBytes16(r), SwapBytes16(m), ones);
+		}
+
+		PackFused16SSSE3(ao + i, rough + i, metal + i, dstRGB + i * 6, dstRGBA + i * 8, count - i);
+	}
+
+	/** The 16 offsets of a dither row as 16-bit lanes, first and second half. */
+	struct DitherRow128
+	{
+		__m128i lo;
+		__m128i hi;
+	};
+
+	ORM_TARGET_SSE2 inline DitherRow128 LoadDitherRow128(const uint8_t* thresholds)
+	{
+		const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(thresholds));
+		const __m128i zero = _mm_setzero_si128();
+		return { _mm_unpacklo_epi8(bytes, zero), _mm_unpackhi_epi8(bytes, zero) };
+	}
+
+	ORM_TARGET_AVX2 inline __m256i LoadDitherRow256(const uint8_t* thresholds)
+	{
+		return _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(thresholds)));
+	}
+
+	ORM_TARGET_SSE2 inline __m128i DitherLanes(__m128i v, __m128i thresholds)
+	{
+		return _mm_srli_epi16(_mm_add_epi16(_mm_sub_epi16(v, _mm_srli_epi16(v, 8)), thresholds), 8);
+	}
+
+	ORM_TARGET_AVX2 inline __m256i DitherLanes(__m256i v, __m256i thresholds)
+	{
+		return _mm256_srli_epi16(_mm256_add_epi16(_mm256_sub_epi16(v, _mm256_srli_epi16(v, 8)), thresholds), 8);
+	}
+
+	/** 16 samples dithered to one register of bytes (DitherSample per lane). */
+	ORM_TARGET_SSE2 inline __m128i Dither16(const uint16_t* src, const DitherRow128& row)
+	{
+		return _mm_packus_epi16(DitherLanes(Load8x16(src), row.lo), DitherLanes(Load8x16(src + 8), row.hi));
+	}
+
+	/** 32 samples dithered to bytes; packus works per lane, the permute restores pixel order. */
+	ORM_TARGET_AVX2 inline __m256i Dither32(const uint16_t* src, __m256i row)
+	{
+		const __m256i packed = _mm256_packus_epi16(DitherLanes(Load16x16(src), row), DitherLanes(Load16x16(src + 16), row));
+		return _mm256_permute4x64_epi64(packed, 0xD8);
+	}
+
+	ORM_TARGET_SSSE3 void PackUnrealRGBDitheredSSSE3(const uint16_t* ao, const uint16_t* rough, const uint16_t* metal, const uint8_t* thresholds,
+		uint8_t* dst, size_t count)
+	{
+		const ShuffleRGB128 masks = LoadShuffleRGB128();
+		const DitherRow128 row = LoadDitherRow128(thresholds);
+
+		size_t i = 0;
+		for(; i + 16 <= count; i += 16)
+		{
+			StoreRGB16(dst + i * 3, Dither16(ao + i, row), Dither16(rough + i, row), Dither16(metal + i, row), masks);
+		}
+
+		PackUnrealRGBDitheredScalar(ao + i, rough + i, metal + i, thresholds, dst + i * 3, count - i);
+	}
+
+	ORM_TARGET_AVX2 void PackUnrealRGBDitheredAVX2(const uint16_t* ao, const uint16_t* rough, const uint16_t* metal, const uint8_t* thresholds,
+		uint8_t* dst, size_t count)
+	{
+		const ShuffleRGB256 masks = LoadShuffleRGB256();
+		const __m256i row = LoadDitherRow256(thresholds);
+
+		size_t i = 0;
+		for(; i + 32 <= count; i += 32)
+		{
+			StoreRGB32(dst + i * 3, Dither32(ao + i, row), Dither32(rough + i, row), Dither32(metal + i, row), masks);
+		}
+
+		PackUnrealRGBDitheredSSSE3(ao + i, rough + i, metal + i, thresholds, dst + i * 3, count - i);
+	}
+
+	ORM_TARGET_SSE2 void PackUnityRGBADitheredSSE2(const uint16_t* ao, const uint16_t* rough, const uint16_t* metal, const uint8_t* thresholds,
+		uint8_t* dst, size_t count)
+	{
+		const __m128i ones = _mm_set1_epi8(static_cast<char>(0xFF));
+		const DitherRow128 row = LoadDitherRow128(thresholds);
+
+		size_t i = 0;
+		for(; i + 16 <= count; i += 16)
+		{
+			StoreUnityRGBA16(dst + i * 4, Dither16(ao + i, row), Dither16(rough + i, row), Dither16(metal + i, row), ones);
+		}
+
+		PackUnityRGBADitheredScalar(ao + i, rough + i, metal + i, thresholds, dst + i * 4, count - i);
+	}
+
+	ORM_TARGET_AVX2 void PackUnityRGBADitheredAVX2(const uint16_t* ao, const uint16_t* rough, const uint16_t* metal, const uint8_t* thresholds,
+		uint8_t* dst, size_t count)
+	{
+		const __m256i ones = _mm256_set1_epi8(static_cast<char>(0xFF));
+		const __m256i row = LoadDitherRow256(thresholds);
+
+		size_t i = 0;
+		for(; i + 32 <= count; i += 32)
+		{
+			StoreUnityRGBA32(dst + i * 4, Dither32(ao + i, row), Dither32(rough + i, row), Dither32(metal + i, row), ones);
+		}
+
+		PackUnityRGBADitheredSSE2(ao + i, rough + i, metal + i, thresholds, dst + i * 4, count - i);
+	}
+
+	ORM_TARGET_SSSE3 void PackFusedDitheredSSSE3(const uint16_t* ao, const uint16_t* rough, const uint16_t* metal, const uint8_t* thresholds,
+		uint8_t* dstRGB, uint8_t* dstRGBA, size_t count)
+	{
+		const ShuffleRGB128 masks = LoadShuffleRGB128();
+		const __m128i ones = _mm_set1_epi8(static_cast<char>(0xFF));
+		const DitherRow128 row = LoadDitherRow128(thresholds);
+
+		size_t i = 0;
+		for(; i + 16 <= count; i += 16)
+		{
+			const __m128i a = Dither16(ao + i, row);
+			const __m128i r = Dither16(rough + i, row);
+			const __m128i m = Dither16(metal + i, row);
+			StoreRGB16(dstRGB + i * 3, a, r, m, masks);
+			StoreUnityRGBA16(dstRGBA + i * 4, a, r, m, ones);
+		}
+
+		PackFusedDitheredScalar(ao + i, rough + i, metal + i, thresholds, dstRGB + i * 3, dstRGBA + i * 4, count - i);
+	}
+
+	ORM_TARGET_AVX2 void PackFusedDitheredAVX2(const uint16_t* ao, const uint16_t* rough, const uint16_t* metal, const uint8_t* thresholds,
+		uint8_t* dstRGB, uint8_t* dstRGBA, size_t count)
+	{
+		const ShuffleRGB256 masks = LoadShuffleRGB256();
+		const __m256i ones = _mm256_set1_epi8(static_cast<char>(0xFF));
+		const __m256i row = LoadDitherRow256(thresholds);
+
+		size_t i = 0;
+		for(; i + 32 <= count; i += 32)
+		{
+			const __m256i a = Dither32(ao + i, row);
+			const __m256i r = Dither32(rough + i, row);
+			const __m256i m = Dither32(metal + i, row);
+			StoreRGB32(dstRGB + i * 3, a, r, m, masks);
+			StoreUnityRGBA32(dstRGBA + i * 4, a, r, m, ones);
+		}
+
+		PackFusedDitheredSSSE3(ao + i, rough + i, metal + i, thresholds, dstRGB + i * 3, dstRGBA + i * 4, count - i);
+	}
+#endif
+
+	struct KernelTable
+	{
+		PackKernels::InstructionSet set = PackKernels::InstructionSet::Scalar;
+		PackFn packUnrealRGB = PackUnrealRGBScalar;
+		PackFn packUnityRGBA = PackUnityRGBAScalar;
+		PackFusedFn packFused = PackFusedScalar;
+		Pack16Fn packUnrealRGB16 = PackUnrealRGB16Scalar;
+		Pack16Fn packUnityRGBA16 = PackUnityRGBA16Scalar;
+		PackFused16Fn packFused16 = PackFused16Scalar;
+		PackDitheredFn packUnrealRGBDithered = PackUnrealRGBDitheredScalar;
+		PackDitheredFn packUnityRGBADithered = PackUnityRGBADitheredScalar;
+		PackFusedDitheredFn packFusedDithered = PackFusedDitheredScalar;
+	};
+
+	KernelTable SelectKernels()
+	{
+		KernelTable table;
+
+#if defined(ORM_PACK_X86)
+		if(CpuFeatures::HasAVX2())
+		{
+			table.set = PackKernels::InstructionSet::AVX2;
+			table.packUnrealRGB = PackUnrealRGBAVX2;
+			table.packUnityRGBA = PackUnityRGBAAVX2;
+			table.packFused = PackFusedAVX2;
+			table.packUnrealRGB16 = PackUnrealRGB16AVX2;
+			table.packUnityRGBA16 = PackUnityRGBA16AVX2;
+			table.packFused16 = PackFused16AVX2;
+			table.packUnrealRGBDithered = PackUnrealRGBDitheredAVX2;
+			table.packUnityRGBADithered = PackUnityRGBADitheredAVX2;
+			table.packFusedDithered = PackFusedDitheredAVX2;
+		}
+		else if(CpuFeatures::HasSSSE3())
+		{
+			table.set = PackKernels::InstructionSet::SSSE3;
+			table.packUnrealRGB = PackUnrealRGBSSSE3;
+			table.packUnityRGBA = PackUnityRGBASSE2;
+			table.packFused = PackFusedSSSE3;
+			table.packUnrealRGB16 = PackUnrealRGB16SSSE3;
+			table.packUnityRGBA16 = PackUnityRGBA16SSE2;
+			table.packFused16 = PackFused16SSSE3;
+			table.packUnrealRGBDithered = PackUnrealRGBDitheredSSSE3;
+			table.packUnityRGBADithered = PackUnityRGBADitheredSSE2;
+			table.packFusedDithered = PackFusedDitheredSSSE3;
+		}
+		else if(CpuFeatures::HasSSE2())
+		{
+			table.packUnityRGBA = PackUnityRGBASSE2;
+			table.packUnityRGBA16 = PackUnityRGBA16SSE2;
+			table.packUnityRGBADithered = PackUnityRGBADitheredSSE2;
+		}
+#endif
+
+		return table;
+	}
+
+	const KernelTable& GetKernels()
+	{
+		static const KernelTable kernels = SelectKernels();
+		return kernels;
+	}
+
+	/** The dither row of image row y, rotated to start at column x. */
+	struct DitherPhase
+	{
+		uint8_t thresholds[16];
+
+		DitherPhase(size_t x, size_t y)
+		{
+			for(size_t k = 0; k < 16; ++k)
+			{
+				thresholds[k] = Bayer.thresholds[y & 15][(x + k) & 15];
+			}
+		}
+	};
+}
+
+PackKernels::InstructionSet PackKernels::GetActiveInstructionSet()
+{
+	return GetKernels().set;
+}
+
+const char* PackKernels::GetInstructionSetName(InstructionSet set)
+{
+	switch(set)
+	{
+	case InstructionSet::Scalar: return "Scalar";
+	case InstructionSet::SSSE3: return "SSSE3";
+	case InstructionSet::AVX2: return "AVX2";
+	default: return "Unknown";
+	}
+}
+
+void PackKernels::PackUnrealRGB(const uint8_t* ao, const uint8_t* rough, const uint8_t* metal, uint8_t* dst, size_t count)
+{
+	GetKernels().packUnrealRGB(ao, rough, metal, dst, count);
+}
+
+void PackKernels::PackUnityRGBA(const uint8_t* ao, const uint8_t* rough, const uint8_t* metal, uint8_t* dst, size_t count)
+{
+	GetKernels().packUnityRGBA(ao, rough, metal, dst, count);
+}
+
+void PackKernels::PackFused(const uint8_t* ao, const uint8_t* rough, const uint8_t* metal, uint8_t* dstRGB, uint8_t* dstRGBA, size_t count)
+{
+	GetKernels().packFused(ao, rough, metal, dstRGB, dstRGBA, count);
+}
+
+void PackKernels::PackUnrealRGB16(const uint16_t* ao, const uint16_t* rough, const uint16_t* metal, uint8_t* dst, size_t count)
+{
+	GetKernels().packUnrealRGB16(ao, rough, metal, dst, count);
+}
+
+void PackKernels::PackUnityRGBA16(const uint16_t* ao, const uint16_t* rough, const uint16_t* metal, uint8_t* dst, size_t count)
+{
+	GetKernels().packUnityRGBA16(ao, rough, metal, dst, count);
+}
+
+void PackKernels::PackFused16(const uint16_t* ao, const uint16_t* rough, const uint16_t* metal, uint8_t* dstRGB, uint8_t* dstRGBA, size_t count)
+{
+	GetKernels().packFused16(ao, rough, metal, dstRGB, dstRGBA, count);
+}
+
+void PackKernels::PackUnrealRGBDithered(const uint16_t* ao, const uint16_t* rough, const uint16_t* metal, uint8_t* dst, size_t count, size_t x, size_t y)
+{
+	GetKernels().packUnrealRGBDithered(ao, rough, metal, DitherPhase(x, y).thresholds, dst, count);
+}
+
+void PackKernels::PackUnityRGBADithered(const uint16_t* ao, const uint16_t* rough, const uint16_t* metal, uint8_t* dst, size_t count, size_t x, size_t y)
+{
+	GetKernels().packUnityRGBADithered(ao, rough, metal, DitherPhase(x, y).thresholds, dst, count);
+}
+
+void PackKernels::PackFusedDithered(const uint16_t* ao, const uint16_t* rough, const uint16_t* metal, uint8_t* dstRGB, uint8_t* dstRGBA,
+	size_t count, size_t x, size_t y)
+{
+	GetKernels().packFusedDithered(ao, rough, metal, DitherPhase(x, y).thresholds, dstRGB, dstRGBA, count);
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * PackKernels
+ *
+ * Channel-interleave kernels that build packed ORM pixels from three grayscale planes.
+ * Each entry point picks the widest implementation supported by the running CPU
+ * (AVX2 -> SSSE3 -> scalar) once, on first use. Kernels work on spans of pixels,
+ * so callers are free to split an image into rows, bands or tiles.
+ */
+namespace PackKernels
+{
+	enum class InstructionSet : int
+	{
+		Scalar,
+		SSSE3,
+		AVX2
+	};
+
+	/** Returns the instruction set selected for the current CPU. */
+	InstructionSet GetActiveInstructionSet();
+
+	/** Returns a printable name of the instruction set. */
+	const char* GetInstructionSetName(InstructionSet set);
+
+	/** Unreal layout: AO (R), Roughness (G), Metallic (B). Writes count * 3 bytes. */
+	void PackUnrealRGB(const uint8_t* ao, const uint8_t* rough, const uint8_t* metal, uint8_t* dst, size_t count);
+
+	/** Unity layout: Metallic (R), AO (G), White (B), Inverted Roughness (A). Writes count * 4 bytes. */
+	void PackUnityRGBA(const uint8_t* ao, const uint8_t* rough, const uint8_t* metal, uint8_t* dst, size_t count);
+
+	/**
+	 * Emits both layouts in one sweep: every input vector is loaded once and stored as
+	 * count * 3 Unreal bytes into dstRGB and count * 4 Unity bytes into dstRGBA.
+	 */
+	void PackFused(const uint8_t* ao, const uint8_t* rough, const uint8_t* metal, uint8_t* dstRGB, uint8_t* dstRGBA, size_t count);
+
+	/**
+	 * 16-bit counterparts: host-order uint16_t planes in, big-endian samples out (count * 6 and
+	 * count * 8 bytes), so the rows go to PngWriter without another pass. White is 65535 and
+	 * smoothness 65535 - roughness.
+	 */
+	void PackUnrealRGB16(const uint16_t* ao, const uint16_t* rough, const uint16_t* metal, uint8_t* dst, size_t count);
+	void PackUnityRGBA16(const uint16_t* ao, const uint16_t* rough, const uint16_t* metal, uint8_t* dst, size_t count);
+	void PackFused16(const uint16_t* ao, const uint16_t* rough, const uint16_t* metal, uint8_t* dstRGB, uint8_t* dstRGBA, size_t count);
+
+	/**
+	 * 8-bit layouts from 16-bit planes, quantized in registers with a 16x16 ordered (Bayer) dither
+	 * instead of truncation, so smooth gradients do not band. (x, y) is the image position of the
+	 * first pixel, which sets the dither phase; widened 8-bit samples (v * 257) come out unchanged.
+	 */
+	void PackUnrealRGBDithered(const uint16_t* ao, const uint16_t* rough, const uint16_t* metal, uint8_t* dst, size_t count, size_t x, size_t y);
+	void PackUnityRGBADithered(const uint16_t* ao, const uint16_t* rough, const uint16_t* metal, uint8_t* dst, size_t count, size_t x, size_t y);
+	void PackFusedDithered(const uint16_t* ao, const uint16_t* rough, const uint16_t* metal, uint8_t* dstRGB, uint8_t* dstRGBA,
+		size_t count, size_t x, size_t y);
+}
@@ -0,0 +1,57 @@
+#include "Resampler.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+
+#define STB_IMAGE_RESIZE_IMPLEMENTATION
+#include <stb_image_resize2.h>
+
+namespace
+{
+	bool ResizeSamples(const void* src, int srcWidth, int srcHeight, int channels,
+		void* dst, int dstWidth, int dstHeight, stbir_datatype type, unsigned int workerCount)
+	{
+		if(!src || !dst || srcWidth <= 0 || srcHeight <= 0 || dstWidth <= 0 || dstHeight <= 0 || channels < 1 || channels > 4)
+		{
+			return false;
+		}
+
+		static constexpr stbir_pixel_layout Layouts[5] = { STBIR_1CHANNEL, STBIR_1CHANNEL, STBIR_2CHANNEL, STBIR_RGB, STBIR_4CHANNEL };
+
+		STBIR_RESIZE resize;
+		stbir_resize_init(&resize, src, srcWidth, srcHeight, 0, dst, dstWidth, dstHeight, 0, Layouts[channels], type);
+
+		ThreadPool& pool = ThreadPool::Get();
+		const unsigned int threads = workerCount ? workerCount : pool.GetWorkerCount() + 1;
+		const int splits = stbir_build_samplers_with_splits(&resize, static_cast<int>(threads));
+		if(splits <= 0)
+		{
+			return false;
+		}
+
+		std::atomic<bool> succeeded{true};
+		pool.ParallelFor(static_cast<size_t>(splits), [&](size_t split)
+		{
+			if(!stbir_resize_extended_split(&resize, static_cast<int>(split), 1))
+			{
+				succeeded = false;
+			}
+		}, workerCount);
+
+		stbir_free_samplers(&resize);
+		return succeeded;
+	}
+}
+
+bool Resampler::Resize(const uint8_t* src, int srcWidth, int srcHeight, int channels,
+	uint8_t* dst, int dstWidth, int dstHeight, unsigned int workerCount)
+{
+	return ResizeSamples(src, srcWidth, srcHeight, channels, dst, dstWidth, dstHeight, STBIR_TYPE_UINT8, workerCount);
+}
+
+bool Resampler::Resize(const uint16_t* src, int srcWidth, int srcHeight, int channels,
+	uint16_t* dst, int dstWidth, int dstHeight, unsigned int workerCount)
+{
+	return ResizeSamples(src, srcWidth, srcHeight, channels, dst, dstWidth, dstHeight, STBIR_TYPE_UINT16, workerCount);
+}
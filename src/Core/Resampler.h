@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdint>
+
+/**
+ * Resampler
+ *
+ * 8 and 16-bit image resizing through stb_image_resize2's SIMD paths. The output is cut into
+ * splits that run as tasks on the shared ThreadPool, so one large resize uses every core.
+ * Data is treated as linear (ORM channels are not colour).
+ */
+class Resampler
+{
+public:
+	/**
+	 * Resizes src (srcWidth x srcHeight, 1-4 interleaved channels) into dst, which must hold
+	 * dstWidth * dstHeight * channels bytes. At most workerCount threads (0 = the whole pool)
+	 * take part. Returns false on invalid arguments or if stb rejects the resize.
+	 */
+	static bool Resize(const uint8_t* src, int srcWidth, int srcHeight, int channels,
+		uint8_t* dst, int dstWidth, int dstHeight, unsigned int workerCount = 0);
+
+	/** Resize for 16-bit samples in host byte order; dst holds dstWidth * dstHeight * channels of them. */
+	static bool Resize(const uint16_t* src, int srcWidth, int srcHeight, int channels,
+		uint16_t* dst, int dstWidth, int dstHeight, unsigned int workerCount = 0);
+};
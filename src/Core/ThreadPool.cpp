@@ -0,0 +1,264 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <exception>
+#include <iostream>
+
+namespace
+{
+	thread_local const ThreadPool* CurrentPool = nullptr;
+	thread_local int CurrentWorkerIndex = -1;
+}
+
+ThreadPool::ThreadPool(unsigned int workerCount)
+{
+	if(workerCount == 0)
+	{
+		workerCount = std::max(1u, std::thread::hardware_concurrency());
+	}
+
+	workerQueues.reserve(workerCount);
+	for(unsigned int i = 0; i < workerCount; ++i)
+	{
+		workerQueues.push_back(std::make_unique<TaskQueue>());
+	}
+
+	workers.reserve(workerCount);
+	for(unsigned int i = 0; i < workerCount; ++i)
+	{
+		workers.emplace_back(&ThreadPool::WorkerLoop, this, i);
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(parkMutex);
+		stopping = true;
+	}
+	parkCondition.notify_all();
+
+	for(std::thread& worker : workers)
+	{
+		worker.join();
+	}
+}
+
+ThreadPool& ThreadPool::Get()
+{
+	static ThreadPool pool;
+	return pool;
+}
+
+unsigned int ThreadPool::GetWorkerCount() const
+{
+	return static_cast<unsigned int>(workers.size());
+}
+
+void ThreadPool::Post(std::function<void()> task)
+{
+	const int index = GetCurrentWorkerIndex();
+	TaskQueue& queue = index >= 0 ? *workerQueues[index] : injectionQueue;
+
+	// Counted before it becomes visible so a concurrent pop can never drive the counter below zero
+	++pendingTasks;
+	{
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		queue.tasks.push_back(std::move(task));
+	}
+
+	if(parkedWorkers > 0)
+	{
+		// Taking the park mutex orders this wake-up after a worker that is about to park
+		{
+			std::lock_guard<std::mutex> lock(parkMutex);
+		}
+		parkCondition.notify_one();
+	}
+}
+
+void ThreadPool::ParallelFor(size_t count, const std::function<void(size_t)>& body, unsigned int maxParallelism)
+{
+	if(count == 0)
+	{
+		return;
+	}
+
+	struct SharedState
+	{
+		std::atomic<size_t> nextIndex{0};
+		std::atomic<size_t> finished{0};
+		size_t count = 0;
+		const std::function<void(size_t)>* body = nullptr;
+
+		std::mutex mutex;
+		std::condition_variable finishedCondition;
+		std::exception_ptr error;
+
+		void Run()
+		{
+			for(size_t index = nextIndex++; index < count; index = nextIndex++)
+			{
+				try
+				{
+					(*body)(index);
+				}
+				catch(...)
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					if(!error)
+					{
+						error = std::current_exception();
+					}
+				}
+
+				if(++finished == count)
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					finishedCondition.notify_all();
+				}
+			}
+		}
+	};
+
+	// Helpers may start after the range is exhausted, so the state is shared and body is only touched for claimed indices
+	auto state = std::make_shared<SharedState>();
+	state->count = count;
+	state->body = &body;
+
+	const size_t threads = maxParallelism == 0 ? GetWorkerCount() + 1 : maxParallelism;
+	const size_t helpers = std::min(threads, count) - 1;
+	for(size_t i = 0; i < helpers; ++i)
+	{
+		Post([state]() { state->Run(); });
+	}
+
+	state->Run();
+
+	while(state->finished < count)
+	{
+		if(!TryRunPendingTask())
+		{
+			std::unique_lock<std::mutex> lock(state->mutex);
+			state->finishedCondition.wait_for(lock, std::chrono::microseconds(200), [&]() { return state->finished == count; });
+		}
+	}
+
+	if(state->error)
+	{
+		std::rethrow_exception(state->error);
+	}
+}
+
+bool ThreadPool::TryRunPendingTask()
+{
+	std::function<void()> task;
+	if(!PopTask(task))
+	{
+		return false;
+	}
+
+	// Post() has nowhere to deliver an exception, and it must not take down the thread that ran the task
+	try
+	{
+		task();
+	}
+	catch(const std::exception& error)
+	{
+		std::cerr << "Unhandled exception in pool task: " << error.what() << "\n";
+	}
+	catch(...)
+	{
+		std::cerr << "Unhandled exception in pool task\n";
+	}
+	return true;
+}
+
+bool ThreadPool::IsWorkerThread() const
+{
+	return GetCurrentWorkerIndex() >= 0;
+}
+
+void ThreadPool::WorkerLoop(unsigned int index)
+{
+	CurrentPool = this;
+	CurrentWorkerIndex = static_cast<int>(index);
+
+	while(true)
+	{
+		if(TryRunPendingTask())
+		{
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(parkMutex);
+		++parkedWorkers;
+		parkCondition.wait(lock, [this]() { return stopping || pendingTasks > 0; });
+		--parkedWorkers;
+
+		if(stopping && pendingTasks == 0)
+		{
+			return;
+		}
+	}
+}
+
+bool ThreadPool::PopTask(std::function<void()>& task)
+{
+	if(pendingTasks == 0)
+	{
+		return false;
+	}
+
+	const auto takeFrom = [&](TaskQueue& queue, bool fromBack)
+	{
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if(queue.tasks.empty())
+		{
+			return false;
+		}
+
+		if(fromBack)
+		{
+			task = std::move(queue.tasks.back());
+			queue.tasks.pop_back();
+		}
+		else
+		{
+			task = std::move(queue.tasks.front());
+			queue.tasks.pop_front();
+		}
+		--pendingTasks;
+		return true;
+	};
+
+	// Own work first (LIFO keeps it cache-warm), then externally posted work, then steal FIFO from the others
+	const int self = GetCurrentWorkerIndex();
+	if(self >= 0 && takeFrom(*workerQueues[self], true))
+	{
+		return true;
+	}
+
+	if(takeFrom(injectionQueue, false))
+	{
+		return true;
+	}
+
+	const size_t queueCount = workerQueues.size();
+	const size_t start = self >= 0 ? static_cast<size_t>(self) + 1 : 0;
+	for(size_t i = 0; i < queueCount; ++i)
+	{
+		const size_t victim = (start + i) % queueCount;
+		if(static_cast<int>(victim) != self && takeFrom(*workerQueues[victim], false))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+int ThreadPool::GetCurrentWorkerIndex() const
+{
+	return CurrentPool == this ? CurrentWorkerIndex : -1;
+}
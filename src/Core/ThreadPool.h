@@ -0,0 +1,113 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/**
+ * ThreadPool
+ *
+ * Long-lived work-stealing pool shared by every stage of the tool (decode, resize, pack,
+ * encode, preview preparation). Each worker owns a deque: tasks posted from a worker go to
+ * the back of its own deque and are popped LIFO, idle workers steal from the front of the
+ * others. Tasks posted from outside the pool land in a shared injection queue. Workers with
+ * nothing to do park on a condition variable instead of spinning.
+ *
+ * Waiting on pool work from inside a task is allowed: Wait() and ParallelFor() keep executing
+ * queued tasks on the calling thread until their own work is finished.
+ */
+class ThreadPool
+{
+public:
+	/** Creates workerCount workers; 0 means one per hardware thread. */
+	explicit ThreadPool(unsigned int workerCount = 0);
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	/** Process-wide pool. */
+	static ThreadPool& Get();
+
+	unsigned int GetWorkerCount() const;
+
+	/** Queues a fire-and-forget task. An exception it throws is reported on stderr and dropped. */
+	void Post(std::function<void()> task);
+
+	/** Queues a task and returns a future for its result. */
+	template<typename F>
+	auto Submit(F&& fn) -> std::future<std::invoke_result_t<std::decay_t<F>>>;
+
+	/**
+	 * Blocks until the future (std::future or std::shared_future) is ready, running queued tasks
+	 * on the calling thread meanwhile.
+	 */
+	template<typename Future>
+	void Wait(const Future& future);
+
+	/**
+	 * Calls body(index) for every index in [0, count) and returns once all calls finished.
+	 * At most maxParallelism threads (0 = the whole pool plus the caller) work on the range;
+	 * the calling thread always takes part. The first exception thrown by body is rethrown.
+	 */
+	void ParallelFor(size_t count, const std::function<void(size_t)>& body, unsigned int maxParallelism = 0);
+
+	/** Runs one queued task on the calling thread. Returns false when nothing was queued. */
+	bool TryRunPendingTask();
+
+	/** True when called from one of this pool's workers. */
+	bool IsWorkerThread() const;
+
+private:
+	struct TaskQueue
+	{
+		std::mutex mutex;
+		std::deque<std::function<void()>> tasks;
+	};
+
+	void WorkerLoop(unsigned int index);
+	bool PopTask(std::function<void()>& task);
+	int GetCurrentWorkerIndex() const;
+
+	std::vector<std::unique_ptr<TaskQueue>> workerQueues;
+	TaskQueue injectionQueue;
+	std::vector<std::thread> workers;
+
+	std::mutex parkMutex;
+	std::condition_variable parkCondition;
+	std::atomic<size_t> pendingTasks{0};
+	std::atomic<unsigned int> parkedWorkers{0};
+	std::atomic<bool> stopping{false};
+};
+
+template<typename F>
+auto ThreadPool::Submit(F&& fn) -> std::future<std::invoke_result_t<std::decay_t<F>>>
+{
+	using Result = std::invoke_result_t<std::decay_t<F>>;
+
+	auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(fn));
+	std::future<Result> future = task->get_future();
+	Post([task]() { (*task)(); });
+	return future;
+}
+
+template<typename Future>
+void ThreadPool::Wait(const Future& future)
+{
+	while(future.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+	{
+		if(!TryRunPendingTask())
+		{
+			future.wait_for(std::chrono::microseconds(200));
+		}
+	}
+}
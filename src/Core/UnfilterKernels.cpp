@@ -0,0 +1,332 @@
+#include "UnfilterKernels.h"
+#include "CpuFeatures.h"
+
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+	#define ORM_UNFILTER_X86 1
+	#include <immintrin.h>
+#endif
+
+#if defined(ORM_UNFILTER_X86) && (defined(__GNUC__) || defined(__clang__))
+	#define ORM_TARGET_SSE2 __attribute__((target("sse2")))
+#else
+	#define ORM_TARGET_SSE2
+#endif
+
+namespace
+{
+	using UnfilterFn = void (*)(const uint8_t*, const uint8_t*, uint8_t*, size_t, size_t);
+
+	void UnfilterNone(const uint8_t* src, const uint8_t*, uint8_t* dst, size_t rowBytes, size_t)
+	{
+		if(dst != src)
+		{
+			std::memmove(dst, src, rowBytes);
+		}
+	}
+
+	void UnfilterSubScalar(const uint8_t* src, const uint8_t*, uint8_t* dst, size_t rowBytes, size_t bpp)
+	{
+		for(size_t i = 0; i < bpp && i < rowBytes; ++i)
+		{
+			dst[i] = src[i];
+		}
+		for(size_t i = bpp; i < rowBytes; ++i)
+		{
+			dst[i] = static_cast<uint8_t>(src[i] + dst[i - bpp]);
+		}
+	}
+
+	void UnfilterUpScalar(const uint8_t* src, const uint8_t* prev, uint8_t* dst, size_t rowBytes, size_t)
+	{
+		for(size_t i = 0; i < rowBytes; ++i)
+		{
+			dst[i] = static_cast<uint8_t>(src[i] + prev[i]);
+		}
+	}
+
+	void UnfilterAverageScalar(const uint8_t* src, const uint8_t* prev, uint8_t* dst, size_t rowBytes, size_t bpp)
+	{
+		for(size_t i = 0; i < bpp && i < rowBytes; ++i)
+		{
+			dst[i] = static_cast<uint8_t>(src[i] + (prev[i] >> 1));
+		}
+		for(size_t i = bpp; i < rowBytes; ++i)
+		{
+			dst[i] = static_cast<uint8_t>(src[i] + ((dst[i - bpp] + prev[i]) >> 1));
+		}
+	}
+
+	inline uint8_t PaethPredictor(int a, int b, int c)
+	{
+		const int pa = std::abs(b - c);
+		const int pb = std::abs(a - c);
+		const int pc = std::abs(a + b - 2 * c);
+		return static_cast<uint8_t>(pa <= pb && pa <= pc ? a : pb <= pc ? b : c);
+	}
+
+	void UnfilterPaethScalar(const uint8_t* src, const uint8_t* prev, uint8_t* dst, size_t rowBytes, size_t bpp)
+	{
+		for(size_t i = 0; i < bpp && i < rowBytes; ++i)
+		{
+			dst[i] = static_cast<uint8_t>(src[i] + prev[i]);
+		}
+		for(size_t i = bpp; i < rowBytes; ++i)
+		{
+			dst[i] = static_cast<uint8_t>(src[i] + PaethPredictor(dst[i - bpp], prev[i], prev[i - bpp]));
+		}
+	}
+
+#if defined(ORM_UNFILTER_X86)
+	// One pixel of Bpp bytes in the low lanes of a register. The bytes are gathered in general
+	// registers; a narrow store to the stack followed by a wide load would stall store forwarding.
+	template<size_t Bpp>
+	ORM_TARGET_SSE2 inline __m128i LoadPixel(const uint8_t* p)
+	{
+		if constexpr(Bpp == 8)
+		{
+			return _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p));
+		}
+		else if constexpr(Bpp == 6)
+		{
+			uint32_t low;
+			uint16_t high;
+			std::memcpy(&low, p, 4);
+			std::memcpy(&high, p + 4, 2);
+			return _mm_insert_epi16(_mm_cvtsi32_si128(static_cast<int>(low)), high, 2);
+		}
+		else if constexpr(Bpp == 4)
+		{
+			uint32_t value;
+			std::memcpy(&value, p, 4);
+			return _mm_cvtsi32_si128(static_cast<int>(value));
+		}
+		else if constexpr(Bpp == 3)
+		{
+			uint16_t low;
+			std::memcpy(&low, p, 2);
+			return _mm_cvtsi32_si128(static_cast<int>(low | static_cast<uint32_t>(p[2]) << 16));
+		}
+		else
+		{
+			uint16_t value;
+			std::memcpy(&value, p, 2);
+			return _mm_cvtsi32_si128(value);
+		}
+	}
+
+	template<size_t Bpp>
+	ORM_TARGET_SSE2 inline void StorePixel(uint8_t* p, __m128i pixel)
+	{
+		if constexpr(Bpp == 8)
+		{
+			_mm_storel_epi64(reinterpret_cast<__m128i*>(p), pixel);
+		}
+		else
+		{
+			const uint32_t low = static_cast<uint32_t>(_mm_cvtsi128_si32(pixel));
+			std::memcpy(p, &low, Bpp < 4 ? 2 : 4);
+			if constexpr(Bpp == 6)
+			{
+				const uint16_t high = static_cast<uint16_t>(_mm_extract_epi16(pixel, 2));
+				std::memcpy(p + 4, &high, 2);
+			}
+			else if constexpr(Bpp == 3)
+			{
+				p[2] = static_cast<uint8_t>(low >> 16);
+			}
+		}
+	}
+
+	template<size_t Bpp>
+	ORM_TARGET_SSE2 void UnfilterSubSSE2(const uint8_t* src, const uint8_t*, uint8_t* dst, size_t rowBytes)
+	{
+		__m128i left = _mm_setzero_si128();
+		for(size_t i = 0; i + Bpp <= rowBytes; i += Bpp)
+		{
+			left = _mm_add_epi8(left, LoadPixel<Bpp>(src + i));
+			StorePixel<Bpp>(dst + i, left);
+		}
+	}
+
+	template<size_t Bpp>
+	ORM_TARGET_SSE2 void UnfilterAverageSSE2(const uint8_t* src, const uint8_t* prev, uint8_t* dst, size_t rowBytes)
+	{
+		const __m128i one = _mm_set1_epi8(1);
+		__m128i left = _mm_setzero_si128();
+		for(size_t i = 0; i + Bpp <= rowBytes; i += Bpp)
+		{
+			// pavgb rounds up; PNG floors, so the carried-in low bit is taken back off
+			const __m128i up = LoadPixel<Bpp>(prev + i);
+			const __m128i average = _mm_sub_epi8(_mm_avg_epu8(left, up), _mm_and_si128(_mm_xor_si128(left, up), one));
+			left = _mm_add_epi8(average, LoadPixel<Bpp>(src + i));
+			StorePixel<Bpp>(dst + i, left);
+		}
+	}
+
+	ORM_TARGET_SSE2 inline __m128i Abs16(__m128i x)
+	{
+		return _mm_max_epi16(x, _mm_sub_epi16(_mm_setzero_si128(), x));
+	}
+
+	ORM_TARGET_SSE2 inline __m128i Select(__m128i mask, __m128i a, __m128i b)
+	{
+		return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+	}
+
+	template<size_t Bpp>
+	ORM_TARGET_SSE2 void UnfilterPaethSSE2(const uint8_t* src, const uint8_t* prev, uint8_t* dst, size_t rowBytes)
+	{
+		// widened to 16 bits so a + b - c cannot wrap; a pixel of up to 8 bytes fills the register
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i lowByte = _mm_set1_epi16(0xFF);
+		__m128i a = zero;	// left
+		__m128i c = zero;	// upper left
+		for(size_t i = 0; i + Bpp <= rowBytes; i += Bpp)
+		{
+			const __m128i b = _mm_unpacklo_epi8(LoadPixel<Bpp>(prev + i), zero);
+			const __m128i x = _mm_unpacklo_epi8(LoadPixel<Bpp>(src + i), zero);
+
+			__m128i pa = _mm_sub_epi16(b, c);		// p - a
+			__m128i pb = _mm_sub_epi16(a, c);		// p - b
+			__m128i pc = Abs16(_mm_add_epi16(pa, pb));
+			pa = Abs16(pa);
+			pb = Abs16(pb);
+
+			// ties go to a, then b, as the specification orders them
+			const __m128i smallest = _mm_min_epi16(pc, _mm_min_epi16(pa, pb));
+			const __m128i nearest = Select(_mm_cmpeq_epi16(pa, smallest), a, Select(_mm_cmpeq_epi16(pb, smallest), b, c));
+
+			a = _mm_and_si128(_mm_add_epi16(nearest, x), lowByte);
+			StorePixel<Bpp>(dst + i, _mm_packus_epi16(a, a));
+			c = b;
+		}
+	}
+
+	ORM_TARGET_SSE2 void UnfilterUpSSE2(const uint8_t* src, const uint8_t* prev, uint8_t* dst, size_t rowBytes, size_t)
+	{
+		size_t i = 0;
+		for(; i + 16 <= rowBytes; i += 16)
+		{
+			const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+			const __m128i up = _mm_loadu_si128(reinterpret_cast<const __m128i*>(prev + i));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_add_epi8(x, up));
+		}
+		UnfilterUpScalar(src + i, prev + i, dst + i, rowBytes - i, 1);
+	}
+
+	/** One byte per pixel: a log-step prefix sum per 16 bytes, carrying the last byte into the next block. */
+	ORM_TARGET_SSE2 void UnfilterSub1SSE2(const uint8_t* src, uint8_t* dst, size_t rowBytes)
+	{
+		__m128i carry = _mm_setzero_si128();
+		size_t i = 0;
+		for(; i + 16 <= rowBytes; i += 16)
+		{
+			__m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+			x = _mm_add_epi8(x, _mm_slli_si128(x, 1));
+			x = _mm_add_epi8(x, _mm_slli_si128(x, 2));
+			x = _mm_add_epi8(x, _mm_slli_si128(x, 4));
+			x = _mm_add_epi8(x, _mm_slli_si128(x, 8));
+			x = _mm_add_epi8(x, carry);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), x);
+			carry = _mm_set1_epi8(static_cast<char>(_mm_extract_epi16(x, 7) >> 8));
+		}
+
+		uint8_t left = i ? dst[i - 1] : 0;
+		for(; i < rowBytes; ++i)
+		{
+			left = static_cast<uint8_t>(left + src[i]);
+			dst[i] = left;
+		}
+	}
+
+	ORM_TARGET_SSE2 void UnfilterSubSSE2(const uint8_t* src, const uint8_t* prev, uint8_t* dst, size_t rowBytes, size_t bpp)
+	{
+		switch(bpp)
+		{
+		case 1: UnfilterSub1SSE2(src, dst, rowBytes); break;
+		case 2: UnfilterSubSSE2<2>(src, prev, dst, rowBytes); break;
+		case 3: UnfilterSubSSE2<3>(src, prev, dst, rowBytes); break;
+		case 4: UnfilterSubSSE2<4>(src, prev, dst, rowBytes); break;
+		case 6: UnfilterSubSSE2<6>(src, prev, dst, rowBytes); break;
+		case 8: UnfilterSubSSE2<8>(src, prev, dst, rowBytes); break;
+		default: UnfilterSubScalar(src, prev, dst, rowBytes, bpp); break;
+		}
+	}
+
+	// a single byte per pixel leaves nothing to run side by side; the scalar loop is as fast
+	ORM_TARGET_SSE2 void UnfilterAverageSSE2(const uint8_t* src, const uint8_t* prev, uint8_t* dst, size_t rowBytes, size_t bpp)
+	{
+		switch(bpp)
+		{
+		case 2: UnfilterAverageSSE2<2>(src, prev, dst, rowBytes); break;
+		case 3: UnfilterAverageSSE2<3>(src, prev, dst, rowBytes); break;
+		case 4: UnfilterAverageSSE2<4>(src, prev, dst, rowBytes); break;
+		case 6: UnfilterAverageSSE2<6>(src, prev, dst, rowBytes); break;
+		case 8: UnfilterAverageSSE2<8>(src, prev, dst, rowBytes); break;
+		default: UnfilterAverageScalar(src, prev, dst, rowBytes, bpp); break;
+		}
+	}
+
+	ORM_TARGET_SSE2 void UnfilterPaethSSE2(const uint8_t* src, const uint8_t* prev, uint8_t* dst, size_t rowBytes, size_t bpp)
+	{
+		switch(bpp)
+		{
+		case 2: UnfilterPaethSSE2<2>(src, prev, dst, rowBytes); break;
+		case 3: UnfilterPaethSSE2<3>(src, prev, dst, rowBytes); break;
+		case 4: UnfilterPaethSSE2<4>(src, prev, dst, rowBytes); break;
+		case 6: UnfilterPaethSSE2<6>(src, prev, dst, rowBytes); break;
+		case 8: UnfilterPaethSSE2<8>(src, prev, dst, rowBytes); break;
+		default: UnfilterPaethScalar(src, prev, dst, rowBytes, bpp); break;
+		}
+	}
+#endif
+
+	struct KernelTable
+	{
+		bool accelerated = false;
+		UnfilterFn filters[5] = { UnfilterNone, UnfilterSubScalar, UnfilterUpScalar, UnfilterAverageScalar, UnfilterPaethScalar };
+	};
+
+	KernelTable SelectKernels()
+	{
+		KernelTable table;
+
+#if defined(ORM_UNFILTER_X86)
+		if(CpuFeatures::HasSSE2())
+		{
+			table.accelerated = true;
+			table.filters[UnfilterKernels::FilterSub] = UnfilterSubSSE2;
+			table.filters[UnfilterKernels::FilterUp] = UnfilterUpSSE2;
+			table.filters[UnfilterKernels::FilterAverage] = UnfilterAverageSSE2;
+			table.filters[UnfilterKernels::FilterPaeth] = UnfilterPaethSSE2;
+		}
+#endif
+
+		return table;
+	}
+
+	const KernelTable& GetKernels()
+	{
+		static const KernelTable kernels = SelectKernels();
+		return kernels;
+	}
+}
+
+bool UnfilterKernels::IsAccelerated()
+{
+	return GetKernels().accelerated;
+}
+
+bool UnfilterKernels::UnfilterRow(uint8_t filter, const uint8_t* src, const uint8_t* prev, uint8_t* dst, size_t rowBytes, size_t bpp)
+{
+	if(filter > FilterPaeth)
+	{
+		return false;
+	}
+
+	GetKernels().filters[filter](src, prev, dst, rowBytes, bpp);
+	return true;
+}
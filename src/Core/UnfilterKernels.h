@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * UnfilterKernels
+ *
+ * Reverses the PNG scanline filters (None, Sub, Up, Average, Paeth) of one row. Sub, Average
+ * and Paeth depend on the pixel to the left, so the SSE2 versions keep a whole pixel (2 to 8
+ * bytes, i.e. 8 and 16-bit gray+alpha, RGB and RGBA) in a register and step pixel by pixel;
+ * Up has no such dependency and runs 16 bytes at a time, as does Sub for one byte per pixel
+ * through a prefix sum. The implementation is picked once, on first use, like PackKernels.
+ */
+namespace UnfilterKernels
+{
+	enum Filter : uint8_t
+	{
+		FilterNone = 0,
+		FilterSub = 1,
+		FilterUp = 2,
+		FilterAverage = 3,
+		FilterPaeth = 4
+	};
+
+	/** True when the SSE2 routines are in use. */
+	bool IsAccelerated();
+
+	/**
+	 * Unfilters rowBytes bytes of src into dst. prev is the already unfiltered row above (all
+	 * zeros for the first row) and bpp the bytes per complete pixel, at least 1. dst may equal
+	 * src or start before it in the same buffer: every byte of src is read before the byte of
+	 * dst at the same index is written. Returns false for an unknown filter type.
+	 */
+	bool UnfilterRow(uint8_t filter, const uint8_t* src, const uint8_t* prev, uint8_t* dst, size_t rowBytes, size_t bpp);
+}
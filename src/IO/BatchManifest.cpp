@@ -0,0 +1,215 @@
+#include "BatchManifest.h"
+#include "ImageLoader.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <utility>
+
+namespace
+{
+	enum Column : int
+	{
+		ColumnAO,
+		ColumnRough,
+		ColumnMetal,
+		ColumnUnreal,
+		ColumnUnity,
+		ColumnResolution,
+		ColumnAOChannel,
+		ColumnRoughChannel,
+		ColumnMetalChannel,
+		ColumnCount
+	};
+
+	std::string Trim(const std::string& text)
+	{
+		const auto begin = std::find_if_not(text.begin(), text.end(), [](unsigned char c) { return std::isspace(c); });
+		const auto end = std::find_if_not(text.rbegin(), text.rend(), [](unsigned char c) { return std::isspace(c); }).base();
+		return begin < end ? std::string(begin, end) : std::string();
+	}
+
+	/** Splits one CSV line; quoted cells may contain commas and doubled quotes. */
+	std::vector<std::string> SplitCsvLine(const std::string& line)
+	{
+		std::vector<std::string> cells(1);
+		bool quoted = false;
+		for(size_t i = 0; i < line.size(); ++i)
+		{
+			const char c = line[i];
+			if(quoted)
+			{
+				if(c == '"' && i + 1 < line.size() && line[i + 1] == '"')
+				{
+					cells.back() += '"';
+					++i;
+				}
+				else if(c == '"')
+				{
+					quoted = false;
+				}
+				else
+				{
+					cells.back() += c;
+				}
+			}
+			else if(c == '"')
+			{
+				quoted = true;
+			}
+			else if(c == ',')
+			{
+				cells.emplace_back();
+			}
+			else
+			{
+				cells.back() += c;
+			}
+		}
+
+		for(std::string& cell : cells)
+		{
+			cell = Trim(cell);
+		}
+		return cells;
+	}
+
+	int ColumnFromName(std::string name)
+	{
+		std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+		if(name == "ao") return ColumnAO;
+		if(name == "rough" || name == "roughness") return ColumnRough;
+		if(name == "metal" || name == "metallic") return ColumnMetal;
+		if(name == "unreal") return ColumnUnreal;
+		if(name == "unity") return ColumnUnity;
+		if(name == "resolution") return ColumnResolution;
+		if(name == "ao_channel") return ColumnAOChannel;
+		if(name == "rough_channel" || name == "roughness_channel") return ColumnRoughChannel;
+		if(name == "metal_channel" || name == "metallic_channel") return ColumnMetalChannel;
+		return -1;
+	}
+}
+
+bool BatchManifest::LoadCsv(const std::string& path, const SaveData& defaults, std::vector<SaveData>& jobs, std::string& error)
+{
+	std::ifstream file(path);
+	if(!file)
+	{
+		error = "cannot open " + path;
+		return false;
+	}
+
+	const std::filesystem::path baseDir = std::filesystem::path(path).parent_path();
+	const auto resolve = [&](const std::string& cell)
+	{
+		if(cell.empty()) return cell;
+		const std::filesystem::path p(cell);
+		return p.is_absolute() ? cell : (baseDir / p).lexically_normal().string();
+	};
+
+	int columns[ColumnCount];
+	std::fill(std::begin(columns), std::end(columns), -1);
+	bool haveHeader = false;
+
+	std::string line;
+	for(size_t lineNumber = 1; std::getline(file, line); ++lineNumber)
+	{
+		if(!line.empty() && line.back() == '\r')
+		{
+			line.pop_back();
+		}
+		const std::string trimmed = Trim(line);
+		if(trimmed.empty() || trimmed[0] == '#')
+		{
+			continue;
+		}
+
+		const std::vector<std::string> cells = SplitCsvLine(line);
+		const std::string where = path + ":" + std::to_string(lineNumber) + ": ";
+
+		if(!haveHeader)
+		{
+			for(size_t i = 0; i < cells.size(); ++i)
+			{
+				const int column = ColumnFromName(cells[i]);
+				if(column < 0)
+				{
+					error = where + "unknown column '" + cells[i] + "'";
+					return false;
+				}
+				columns[column] = static_cast<int>(i);
+			}
+			if(columns[ColumnAO] < 0 || columns[ColumnRough] < 0 || columns[ColumnMetal] < 0)
+			{
+				error = where + "header must name the ao, rough and metal columns";
+				return false;
+			}
+			haveHeader = true;
+			continue;
+		}
+
+		const auto cell = [&](Column column) -> std::string
+		{
+			const int index = columns[column];
+			return index >= 0 && index < static_cast<int>(cells.size()) ? cells[index] : std::string();
+		};
+
+		SaveData job = defaults;
+		job.ao = resolve(cell(ColumnAO));
+		job.rough = resolve(cell(ColumnRough));
+		job.metal = resolve(cell(ColumnMetal));
+		job.saveUnrealPath = resolve(cell(ColumnUnreal));
+		job.saveUnityPath = resolve(cell(ColumnUnity));
+		job.generateUnreal = !job.saveUnrealPath.empty();
+		job.generateUnity = !job.saveUnityPath.empty();
+
+		if(job.ao.empty() || job.rough.empty() || job.metal.empty())
+		{
+			error = where + "ao, rough and metal are required";
+			return false;
+		}
+		if(!job.generateUnreal && !job.generateUnity)
+		{
+			error = where + "no unreal or unity output";
+			return false;
+		}
+
+		const std::string resolution = cell(ColumnResolution);
+		if(!resolution.empty())
+		{
+			char* end = nullptr;
+			const long value = std::strtol(resolution.c_str(), &end, 10);
+			if(*end != '\0' || value <= 0 || value > 65536)
+			{
+				error = where + "invalid resolution '" + resolution + "'";
+				return false;
+			}
+			job.targetResolution = static_cast<int>(value);
+		}
+
+		const std::pair<Column, SourceChannel*> channels[3] =
+		{
+			{ ColumnAOChannel, &job.aoChannel }, { ColumnRoughChannel, &job.roughChannel }, { ColumnMetalChannel, &job.metalChannel }
+		};
+		for(const auto& [column, channel] : channels)
+		{
+			const std::string name = cell(column);
+			if(!name.empty() && !ImageLoader::ParseChannel(name, *channel))
+			{
+				error = where + "invalid channel '" + name + "'";
+				return false;
+			}
+		}
+
+		jobs.push_back(std::move(job));
+	}
+
+	if(!haveHeader)
+	{
+		error = path + ": empty manifest";
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "Types.h"
+
+/**
+ * BatchManifest
+ *
+ * Reads a CSV list of material sets into SaveData jobs. The first non-comment line is a
+ * header naming the columns (any order, case-insensitive):
+ *
+ *     ao, rough, metal, unreal, unity, resolution, ao_channel, rough_channel, metal_channel
+ *
+ * "roughness" and "metallic" are accepted as aliases. unreal/unity are output paths; an empty
+ * cell skips that layout. resolution and the *_channel columns (luma, r, g, b, a) are optional. Relative paths are resolved against the
+ * manifest's directory. Lines starting with '#' and blank lines are ignored; cells may be quoted.
+ */
+class BatchManifest
+{
+public:
+	/**
+	 * Appends one job per row to jobs, each starting as a copy of defaults. Returns false and
+	 * describes the first problem in error if the file cannot be read or a row is malformed.
+	 */
+	static bool LoadCsv(const std::string& path, const SaveData& defaults, std::vector<SaveData>& jobs, std::string& error);
+};
@@ -0,0 +1,442 @@
+#include "Deflate.h"
+
+#include <algorithm>
+#include <cstring>
+#include <initializer_list>
+
+#if defined(_MSC_VER)
+	#include <intrin.h>
+#endif
+
+namespace
+{
+	constexpr size_t MinMatch = 3;
+	constexpr size_t MaxMatch = 258;
+	constexpr size_t LazyLimit = 32;
+	constexpr int HashBits = 15;
+	constexpr size_t WindowMask = Deflate::WindowSize - 1;
+
+	constexpr uint16_t LengthBase[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+	constexpr uint8_t LengthExtra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+	constexpr uint16_t DistanceBase[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+	constexpr uint8_t DistanceExtra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+	constexpr uint32_t ReverseBits(uint32_t code, int length)
+	{
+		uint32_t reversed = 0;
+		for(int i = 0; i < length; ++i)
+		{
+			reversed = (reversed << 1) | ((code >> i) & 1);
+		}
+		return reversed;
+	}
+
+	/** Fixed Huffman code (RFC 1951 3.2.6), stored bit-reversed for the LSB-first bit writer. */
+	struct FixedCodes
+	{
+		uint16_t literalCode[288] = {};
+		uint8_t literalLength[288] = {};
+		uint8_t lengthSymbol[MaxMatch + 1] = {};
+		uint8_t distanceSymbolSmall[256] = {};	// distance - 1 for distances <= 256
+		uint8_t distanceSymbolLarge[256] = {};	// (distance - 1) >> 7 for larger distances
+		uint32_t crcTable[256] = {};
+
+		constexpr FixedCodes()
+		{
+			for(uint32_t v = 0; v < 288; ++v)
+			{
+				uint32_t code = 0;
+				int length = 0;
+				if(v < 144) { code = 0x30 + v; length = 8; }
+				else if(v < 256) { code = 0x190 + (v - 144); length = 9; }
+				else if(v < 280) { code = v - 256; length = 7; }
+				else { code = 0xC0 + (v - 280); length = 8; }
+
+				literalCode[v] = static_cast<uint16_t>(ReverseBits(code, length));
+				literalLength[v] = static_cast<uint8_t>(length);
+			}
+
+			for(int symbol = 0; symbol < 29; ++symbol)
+			{
+				const int last = symbol + 1 < 29 ? LengthBase[symbol + 1] - 1 : LengthBase[symbol];
+				for(int length = LengthBase[symbol]; length <= last && length <= static_cast<int>(MaxMatch); ++length)
+				{
+					lengthSymbol[length] = static_cast<uint8_t>(symbol);
+				}
+			}
+			lengthSymbol[MaxMatch] = 28;
+
+			for(int symbol = 0; symbol < 30; ++symbol)
+			{
+				const int first = DistanceBase[symbol];
+				const int last = first + (1 << DistanceExtra[symbol]) - 1;
+				for(int distance = first; distance <= last; ++distance)
+				{
+					if(distance <= 256)
+					{
+						distanceSymbolSmall[distance - 1] = static_cast<uint8_t>(symbol);
+					}
+					else
+					{
+						distanceSymbolLarge[(distance - 1) >> 7] = static_cast<uint8_t>(symbol);
+					}
+				}
+			}
+
+			for(uint32_t n = 0; n < 256; ++n)
+			{
+				uint32_t c = n;
+				for(int k = 0; k < 8; ++k)
+				{
+					c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+				}
+				crcTable[n] = c;
+			}
+		}
+	};
+
+	constexpr FixedCodes Codes;
+
+	/**
+	 * LSB-first bit writer. Bits are flushed 32 at a time into out, which grows ahead of the
+	 * write position and is trimmed by Finish; literal-heavy streams (16-bit samples) emit a
+	 * code for nearly every input byte, so this is on the hot path.
+	 */
+	class BitWriter
+	{
+	public:
+		explicit BitWriter(std::vector<uint8_t>& target) : out(target), start(target.size()), length(target.size()) {}
+
+		void Put(uint32_t value, int count)
+		{
+			bits |= static_cast<uint64_t>(value) << bitCount;
+			bitCount += count;
+			if(bitCount >= 32)
+			{
+				Reserve(4);
+				const uint32_t word = static_cast<uint32_t>(bits);
+				std::memcpy(out.data() + length, &word, 4);		// little-endian hosts, as MatchLength
+				length += 4;
+				bits >>= 32;
+				bitCount -= 32;
+			}
+		}
+
+		void AlignToByte()
+		{
+			Reserve(8);
+			while(bitCount > 0)
+			{
+				out[length++] = static_cast<uint8_t>(bits);
+				bits >>= 8;
+				bitCount = std::max(bitCount - 8, 0);
+			}
+			bits = 0;
+		}
+
+		/** Appends whole bytes; the stream must be byte aligned. */
+		void PutBytes(std::initializer_list<uint8_t> bytes)
+		{
+			Reserve(bytes.size());
+			for(const uint8_t byte : bytes)
+			{
+				out[length++] = byte;
+			}
+		}
+
+		void Finish()
+		{
+			out.resize(length);
+		}
+
+	private:
+		void Reserve(size_t bytes)
+		{
+			// doubles what this block wrote so far, not the whole vector it appends to
+			if(length + bytes > out.size())
+			{
+				out.resize(length + bytes + std::max<size_t>(length - start, 4096));
+			}
+		}
+
+		std::vector<uint8_t>& out;
+		size_t start;
+		size_t length;
+		uint64_t bits = 0;
+		int bitCount = 0;
+	};
+
+	inline uint32_t Hash3(const uint8_t* p)
+	{
+		const uint32_t v = static_cast<uint32_t>(p[0]) << 16 | static_cast<uint32_t>(p[1]) << 8 | p[2];
+		return (v * 2654435761u) >> (32 - HashBits);
+	}
+
+	inline int CountTrailingZeros(uint64_t value)
+	{
+#if defined(_MSC_VER)
+		unsigned long index = 0;
+		_BitScanForward64(&index, value);
+		return static_cast<int>(index);
+#else
+		return __builtin_ctzll(value);
+#endif
+	}
+
+	/** Length of the common prefix of a and b, compared 8 bytes at a time (little-endian hosts). */
+	inline size_t MatchLength(const uint8_t* a, const uint8_t* b, size_t maxLength)
+	{
+		size_t length = 0;
+		while(length + 8 <= maxLength)
+		{
+			uint64_t x, y;
+			std::memcpy(&x, a + length, 8);
+			std::memcpy(&y, b + length, 8);
+			if(x != y)
+			{
+				return length + CountTrailingZeros(x ^ y) / 8;
+			}
+			length += 8;
+		}
+		while(length < maxLength && a[length] == b[length])
+		{
+			++length;
+		}
+		return length;
+	}
+
+	struct Match
+	{
+		size_t length = 0;
+		size_t distance = 0;
+	};
+
+	class MatchFinder
+	{
+	public:
+		MatchFinder(const uint8_t* source, size_t sourceSize, int chainLength)
+			: data(source), size(sourceSize), maxChain(chainLength), head(size_t(1) << HashBits, -1), prev(Deflate::WindowSize, -1)
+		{
+		}
+
+		void Insert(size_t pos)
+		{
+			if(pos + MinMatch > size)
+			{
+				return;
+			}
+			Insert(pos, Hash3(data + pos));
+		}
+
+		/** Longest earlier match for pos; must be called before Insert(pos). */
+		Match Find(size_t pos) const
+		{
+			return pos + MinMatch > size ? Match{} : Find(pos, Hash3(data + pos));
+		}
+
+		/** Find(pos) followed by Insert(pos), hashing the position once. */
+		Match FindAndInsert(size_t pos)
+		{
+			if(pos + MinMatch > size)
+			{
+				return {};
+			}
+			const uint32_t h = Hash3(data + pos);
+			const Match match = Find(pos, h);
+			Insert(pos, h);
+			return match;
+		}
+
+	private:
+		void Insert(size_t pos, uint32_t h)
+		{
+			prev[pos & WindowMask] = head[h];
+			head[h] = static_cast<int32_t>(pos);
+		}
+
+		Match Find(size_t pos, uint32_t h) const
+		{
+			Match best;
+			const size_t maxLength = std::min(MaxMatch, size - pos);
+			const uint8_t* current = data + pos;
+			int32_t candidate = head[h];
+
+			for(int chain = maxChain; candidate >= 0 && chain > 0; --chain)
+			{
+				const size_t distance = pos - static_cast<size_t>(candidate);
+				if(distance > Deflate::WindowSize)
+				{
+					break;
+				}
+
+				const uint8_t* earlier = data + candidate;
+				if(earlier[best.length] == current[best.length])
+				{
+					const size_t length = MatchLength(earlier, current, maxLength);
+					if(length > best.length)
+					{
+						best.length = length;
+						best.distance = distance;
+						if(length == maxLength)
+						{
+							break;
+						}
+					}
+				}
+
+				// Ring slots get recycled, so only strictly older candidates continue the chain
+				const int32_t next = prev[static_cast<size_t>(candidate) & WindowMask];
+				if(next >= candidate)
+				{
+					break;
+				}
+				candidate = next;
+			}
+
+			if(best.length < MinMatch)
+			{
+				best = {};
+			}
+			return best;
+		}
+
+		const uint8_t* data;
+		size_t size;
+		int maxChain;
+		std::vector<int32_t> head;
+		std::vector<int32_t> prev;
+	};
+
+	void PutLiteral(BitWriter& writer, uint8_t value)
+	{
+		writer.Put(Codes.literalCode[value], Codes.literalLength[value]);
+	}
+
+	void PutMatch(BitWriter& writer, const Match& match)
+	{
+		const int lengthSymbol = Codes.lengthSymbol[match.length];
+		const int literal = 257 + lengthSymbol;
+		writer.Put(Codes.literalCode[literal], Codes.literalLength[literal]);
+		writer.Put(static_cast<uint32_t>(match.length - LengthBase[lengthSymbol]), LengthExtra[lengthSymbol]);
+
+		const size_t d = match.distance - 1;
+		const int distanceSymbol = d < 256 ? Codes.distanceSymbolSmall[d] : Codes.distanceSymbolLarge[d >> 7];
+		writer.Put(ReverseBits(static_cast<uint32_t>(distanceSymbol), 5), 5);
+		writer.Put(static_cast<uint32_t>(match.distance - DistanceBase[distanceSymbol]), DistanceExtra[distanceSymbol]);
+	}
+}
+
+void Deflate::CompressBlock(const uint8_t* data, size_t dictSize, size_t size, bool finalBlock,
+	const DeflateParams& params, std::vector<uint8_t>& out)
+{
+	BitWriter writer(out);
+	writer.Put(finalBlock ? 1u : 0u, 1);
+	writer.Put(1u, 2);	// BTYPE 01: fixed Huffman
+
+	MatchFinder finder(data, size, std::max(1, params.maxChainLength));
+	for(size_t pos = dictSize > WindowSize ? dictSize - WindowSize : 0; pos < dictSize; ++pos)
+	{
+		finder.Insert(pos);
+	}
+
+	size_t pos = dictSize;
+	Match current = finder.FindAndInsert(pos);
+
+	while(pos < size)
+	{
+		if(current.length >= MinMatch)
+		{
+			if(params.lazyMatching && current.length < LazyLimit)
+			{
+				const Match next = finder.Find(pos + 1);
+				if(next.length > current.length)
+				{
+					PutLiteral(writer, data[pos]);
+					++pos;
+					finder.Insert(pos);
+					current = next;
+					continue;
+				}
+			}
+
+			PutMatch(writer, current);
+			if(params.indexWholeMatch)
+			{
+				for(size_t k = 1; k < current.length; ++k)
+				{
+					finder.Insert(pos + k);
+				}
+			}
+			pos += current.length;
+		}
+		else
+		{
+			PutLiteral(writer, data[pos]);
+			++pos;
+		}
+
+		current = finder.FindAndInsert(pos);
+	}
+
+	writer.Put(Codes.literalCode[256], Codes.literalLength[256]);	// end of block
+
+	if(!finalBlock)
+	{
+		// Sync flush: an empty stored block realigns the stream so the next segment can start on a byte
+		writer.Put(0u, 3);
+		writer.AlignToByte();
+		writer.PutBytes({ 0x00, 0x00, 0xFF, 0xFF });
+	}
+	writer.AlignToByte();
+	writer.Finish();
+}
+
+uint32_t Deflate::Adler32(const uint8_t* data, size_t size, uint32_t adler)
+{
+	constexpr uint32_t Base = 65521;
+	constexpr size_t MaxRun = 5552;	// largest n keeping the sums below 2^32 before the modulo
+
+	uint32_t a = adler & 0xFFFF;
+	uint32_t b = adler >> 16;
+	while(size > 0)
+	{
+		const size_t run = std::min(size, MaxRun);
+		for(size_t i = 0; i < run; ++i)
+		{
+			a += data[i];
+			b += a;
+		}
+		a %= Base;
+		b %= Base;
+		data += run;
+		size -= run;
+	}
+	return (b << 16) | a;
+}
+
+uint32_t Deflate::Adler32Combine(uint32_t adlerA, uint32_t adlerB, size_t sizeB)
+{
+	constexpr uint32_t Base = 65521;
+
+	const uint32_t remainder = static_cast<uint32_t>(sizeB % Base);
+	uint32_t sum1 = adlerA & 0xFFFF;
+	uint32_t sum2 = static_cast<uint32_t>((static_cast<uint64_t>(remainder) * sum1) % Base);
+	sum1 += (adlerB & 0xFFFF) + Base - 1;
+	sum2 += (adlerA >> 16) + (adlerB >> 16) + Base - remainder;
+
+	if(sum1 >= Base) sum1 -= Base;
+	if(sum1 >= Base) sum1 -= Base;
+	if(sum2 >= (Base << 1)) sum2 -= (Base << 1);
+	if(sum2 >= Base) sum2 -= Base;
+	return sum1 | (sum2 << 16);
+}
+
+uint32_t Deflate::Crc32(const uint8_t* data, size_t size, uint32_t crc)
+{
+	crc = ~crc;
+	for(size_t i = 0; i < size; ++i)
+	{
+		crc = Codes.crcTable[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+	}
+	return ~crc;
+}
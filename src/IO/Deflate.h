@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/** Match-finder tuning for Deflate::CompressBlock. */
+struct DeflateParams
+{
+	int maxChainLength = 32;	// hash-chain candidates examined per position
+	bool lazyMatching = true;	// defer a match by one byte when the next position matches longer
+	bool indexWholeMatch = true;	// hash every position covered by a match, not only its first byte
+};
+
+/**
+ * Deflate
+ *
+ * Minimal raw-deflate (RFC 1951) encoder plus the checksums needed to wrap it in zlib/PNG
+ * streams. Blocks use the fixed Huffman code, so independently compressed segments can be
+ * produced in parallel and concatenated: every non-final block ends with a sync flush
+ * (empty stored block) that leaves the stream byte aligned.
+ */
+class Deflate
+{
+public:
+	/** Size of the LZ77 window; also the largest useful preset dictionary. */
+	static constexpr size_t WindowSize = 32768;
+
+	/**
+	 * Compresses data[dictSize, size) as one block and appends it to out. The bytes in
+	 * data[0, dictSize) are not emitted but may be referenced by matches, which lets a segment
+	 * continue the window of the previous one. Non-final blocks are followed by a sync flush.
+	 */
+	static void CompressBlock(const uint8_t* data, size_t dictSize, size_t size, bool finalBlock,
+		const DeflateParams& params, std::vector<uint8_t>& out);
+
+	/** Adler-32 of data, continuing from adler (1 for a fresh checksum). */
+	static uint32_t Adler32(const uint8_t* data, size_t size, uint32_t adler = 1);
+
+	/** Adler-32 of the concatenation A + B given adler(A), adler(B) and the length of B. */
+	static uint32_t Adler32Combine(uint32_t adlerA, uint32_t adlerB, size_t sizeB);
+
+	/** CRC-32 (PNG/zlib polynomial) of data, continuing from crc (0 for a fresh checksum). */
+	static uint32_t Crc32(const uint8_t* data, size_t size, uint32_t crc = 0);
+};
@@ -0,0 +1,171 @@
+#include "FileWatcher.h"
+
+#ifdef __linux__
+	#include <sys/inotify.h>
+	#include <unistd.h>
+#endif
+
+FileWatcher::FileWatcher(std::chrono::milliseconds settleTime) : settleTime(settleTime)
+{
+#ifdef __linux__
+	notifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#endif
+}
+
+FileWatcher::~FileWatcher()
+{
+	Clear();
+#ifdef __linux__
+	if(notifyFd >= 0)
+	{
+		close(notifyFd);
+	}
+#endif
+}
+
+std::string FileWatcher::NormalizePath(const std::string& path)
+{
+	std::error_code error;
+	const std::filesystem::path absolute = std::filesystem::absolute(path, error);
+	return (error ? std::filesystem::path(path) : absolute).lexically_normal().string();
+}
+
+FileWatcher::FileState FileWatcher::ReadState(const std::filesystem::path& path)
+{
+	FileState state;
+	std::error_code error;
+	state.size = std::filesystem::file_size(path, error);
+	if(error)
+	{
+		return FileState{};
+	}
+	state.writeTime = std::filesystem::last_write_time(path, error);
+	state.exists = !error;
+	return state;
+}
+
+void FileWatcher::Watch(const std::string& path)
+{
+	const std::filesystem::path key = NormalizePath(path);
+	if(files.count(key))
+	{
+		return;
+	}
+
+	WatchedFile& file = files[key];
+	file.state = ReadState(key);
+
+#ifdef __linux__
+	if(notifyFd >= 0)
+	{
+		const std::filesystem::path directory = key.parent_path();
+		const int wd = inotify_add_watch(notifyFd, directory.c_str(), IN_CLOSE_WRITE | IN_MODIFY | IN_MOVED_TO | IN_CREATE);
+		if(wd >= 0)
+		{
+			watchedDirectories[wd] = directory;
+			file.polled = false;
+		}
+	}
+#endif
+}
+
+void FileWatcher::Clear()
+{
+#ifdef __linux__
+	for(const auto& [wd, directory] : watchedDirectories)
+	{
+		inotify_rm_watch(notifyFd, wd);
+	}
+#endif
+	watchedDirectories.clear();
+	files.clear();
+}
+
+void FileWatcher::MarkChanged(const std::filesystem::path& key, WatchedFile& file, std::chrono::steady_clock::time_point now)
+{
+	file.pending = true;
+	file.pendingState = ReadState(key);
+	file.lastChange = now;
+}
+
+void FileWatcher::ReadNotifications(std::chrono::steady_clock::time_point now)
+{
+#ifdef __linux__
+	alignas(inotify_event) char buffer[16 * 1024];
+	for(;;)
+	{
+		const ssize_t length = read(notifyFd, buffer, sizeof(buffer));
+		if(length <= 0)
+		{
+			break;
+		}
+
+		for(ssize_t offset = 0; offset < length;)
+		{
+			const inotify_event* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+			offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+
+			const auto directory = watchedDirectories.find(event->wd);
+			if(directory == watchedDirectories.end() || event->len == 0)
+			{
+				continue;
+			}
+
+			const auto file = files.find((directory->second / event->name).lexically_normal());
+			if(file != files.end())
+			{
+				MarkChanged(file->first, file->second, now);
+			}
+		}
+	}
+#else
+	(void)now;
+#endif
+}
+
+std::vector<std::string> FileWatcher::Poll()
+{
+	const auto now = std::chrono::steady_clock::now();
+	std::vector<std::string> changed;
+
+	if(notifyFd >= 0)
+	{
+		ReadNotifications(now);
+	}
+
+	for(auto& [key, file] : files)
+	{
+		if(!file.pending)
+		{
+			// without notifications the file is compared against its baseline
+			if(file.polled && !(ReadState(key) == file.state))
+			{
+				MarkChanged(key, file, now);
+			}
+			continue;
+		}
+
+		if(now - file.lastChange < settleTime)
+		{
+			continue;
+		}
+
+		// Still being written (or replaced) if size or timestamp moved since the last look
+		const FileState current = ReadState(key);
+		if(!current.exists || !(current == file.pendingState))
+		{
+			file.pendingState = current;
+			file.lastChange = now;
+			continue;
+		}
+
+		file.pending = false;
+		if(!(current == file.state))
+		{
+			file.state = current;
+			changed.push_back(key.string());
+		}
+	}
+
+	return changed;
+}
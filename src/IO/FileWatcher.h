@@ -0,0 +1,70 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <string>
+#include <vector>
+
+/**
+ * FileWatcher
+ *
+ * Reports input files that were rewritten. On Linux the parent directories are watched
+ * with inotify (so save-by-rename is seen too); elsewhere the files are polled. A change is
+ * only reported once the file has stayed untouched, with a stable size and timestamp, for
+ * the settle time, which skips half-written exports. Not thread-safe; poll from one thread.
+ */
+class FileWatcher
+{
+public:
+	explicit FileWatcher(std::chrono::milliseconds settleTime = std::chrono::milliseconds(500));
+	~FileWatcher();
+
+	FileWatcher(const FileWatcher&) = delete;
+	FileWatcher& operator=(const FileWatcher&) = delete;
+
+	/** Starts watching path; the current contents are the baseline. */
+	void Watch(const std::string& path);
+
+	/** Stops watching everything. */
+	void Clear();
+
+	/** Non-blocking. Returns the watched paths, normalized, that changed and settled since the last call. */
+	std::vector<std::string> Poll();
+
+	/** Absolute, lexically normal form used to identify files; compare Poll results against it. */
+	static std::string NormalizePath(const std::string& path);
+
+private:
+	struct FileState
+	{
+		bool exists = false;
+		uintmax_t size = 0;
+		std::filesystem::file_time_type writeTime{};
+
+		bool operator==(const FileState& other) const
+		{
+			return exists == other.exists && size == other.size && writeTime == other.writeTime;
+		}
+	};
+
+	struct WatchedFile
+	{
+		FileState state;			// last reported (or baseline) contents
+		bool polled = true;			// no directory notification, compared on every Poll
+		bool pending = false;		// changed, waiting to settle
+		FileState pendingState;
+		std::chrono::steady_clock::time_point lastChange;
+	};
+
+	static FileState ReadState(const std::filesystem::path& path);
+	static void MarkChanged(const std::filesystem::path& key, WatchedFile& file, std::chrono::steady_clock::time_point now);
+	void ReadNotifications(std::chrono::steady_clock::time_point now);
+
+	std::chrono::milliseconds settleTime;
+	std::map<std::filesystem::path, WatchedFile> files;	// keyed by normalized absolute path
+
+	int notifyFd = -1;									// inotify instance, -1 when polling
+	std::map<int, std::filesystem::path> watchedDirectories;	// inotify watch descriptor -> directory
+};
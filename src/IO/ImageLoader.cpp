@@ -0,0 +1,211 @@
+#include "ImageLoader.h"
+#include "MappedFile.h"
+#include "PngReader.h"
+
+#include <algorithm>
+#include <cctype>
+#include <climits>
+#include <iostream>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+unsigned char* ImageLoader::Load(const std::string& path, int& width, int& height, int& channels, int desiredChannels)
+{
+	// Decodes straight from the mapped file pages instead of an extra stdio-buffered copy
+	const MappedFile file(path);
+	if(!file.IsOpen() || file.GetSize() > static_cast<size_t>(INT_MAX))
+	{
+		return nullptr;
+	}
+
+	// Plain 8/16-bit PNGs take the in-tree path with SIMD unfiltering; stb's own converter keeps the
+	// channel conversion bit-identical to what stbi_load would return
+	if(unsigned char* pixels = PngReader::Decode(file.GetData(), file.GetSize(), width, height, channels))
+	{
+		if(desiredChannels == 0 || desiredChannels == channels)
+		{
+			return pixels;
+		}
+		return stbi__convert_format(pixels, channels, desiredChannels, static_cast<unsigned int>(width), static_cast<unsigned int>(height));
+	}
+
+	return stbi_load_from_memory(file.GetData(), static_cast<int>(file.GetSize()), &width, &height, &channels, desiredChannels);
+}
+
+uint16_t* ImageLoader::Load16(const std::string& path, int& width, int& height, int& channels, int desiredChannels)
+{
+	const MappedFile file(path);
+	if(!file.IsOpen() || file.GetSize() > static_cast<size_t>(INT_MAX))
+	{
+		return nullptr;
+	}
+
+	// 8-bit files are converted at 8 bits and widened afterwards, exactly as stbi_load_16 does
+	if(!stbi_is_16_bit_from_memory(file.GetData(), static_cast<int>(file.GetSize())))
+	{
+		unsigned char* narrow = Load(path, width, height, channels, desiredChannels);
+		const size_t count = narrow ? static_cast<size_t>(width) * height * (desiredChannels ? desiredChannels : channels) : 0;
+		uint16_t* wide = narrow ? static_cast<uint16_t*>(STBI_REALLOC(narrow, count * 2)) : nullptr;
+		if(!wide)
+		{
+			stbi_image_free(narrow);
+			return nullptr;
+		}
+
+		// back to front, so no sample is overwritten before it is read
+		const unsigned char* samples = reinterpret_cast<const unsigned char*>(wide);
+		for(size_t i = count; i-- > 0;)
+		{
+			wide[i] = static_cast<uint16_t>(samples[i] * 257);
+		}
+		return wide;
+	}
+
+	if(uint16_t* pixels = PngReader::Decode16(file.GetData(), file.GetSize(), width, height, channels))
+	{
+		if(desiredChannels == 0 || desiredChannels == channels)
+		{
+			return pixels;
+		}
+		return stbi__convert_format16(pixels, channels, desiredChannels, static_cast<unsigned int>(width), static_cast<unsigned int>(height));
+	}
+
+	return stbi_load_16_from_memory(file.GetData(), static_cast<int>(file.GetSize()), &width, &height, &channels, desiredChannels);
+}
+
+namespace
+{
+	template<int Stride, typename Sample>
+	void CopyChannel(const Sample* src, Sample* dst, size_t count)
+	{
+		for(size_t i = 0; i < count; ++i)
+		{
+			dst[i] = src[i * Stride];
+		}
+	}
+
+	unsigned char* LoadSamples(const std::string& path, int& width, int& height, int& channels, int desiredChannels, unsigned char*)
+	{
+		return ImageLoader::Load(path, width, height, channels, desiredChannels);
+	}
+
+	uint16_t* LoadSamples(const std::string& path, int& width, int& height, int& channels, int desiredChannels, uint16_t*)
+	{
+		return ImageLoader::Load16(path, width, height, channels, desiredChannels);
+	}
+
+	/** LoadChannel for either sample type; a channel the source lacks reads as opaque. */
+	template<typename Sample>
+	Sample* LoadPlane(const std::string& path, int& width, int& height, SourceChannel channel, Sample opaque)
+	{
+		int stored = 0;
+		if(channel == SourceChannel::Luma)
+		{
+			// stb only converts when the stored layout differs, so gray files come back untouched
+			return LoadSamples(path, width, height, stored, 1, static_cast<Sample*>(nullptr));
+		}
+
+		Sample* data = LoadSamples(path, width, height, stored, 0, static_cast<Sample*>(nullptr));
+		if(!data)
+		{
+			return nullptr;
+		}
+		if(stored == 1)
+		{
+			// gray is every color channel; the missing alpha overwrites the samples in place
+			if(channel == SourceChannel::Alpha)
+			{
+				std::fill(data, data + static_cast<size_t>(width) * height, opaque);
+			}
+			return data;
+		}
+
+		// gray+alpha carries its gray in every color channel; -1 = the source has no such channel
+		int index = static_cast<int>(channel) - static_cast<int>(SourceChannel::Red);
+		if(stored == 2)
+		{
+			index = channel == SourceChannel::Alpha ? 1 : 0;
+		}
+		else if(index >= stored)
+		{
+			index = -1;
+		}
+
+		const size_t count = static_cast<size_t>(width) * height;
+		Sample* plane = static_cast<Sample*>(STBI_MALLOC(count * sizeof(Sample)));
+		if(plane)
+		{
+			const Sample* src = data + std::max(index, 0);
+			switch(index < 0 ? 0 : stored)
+			{
+			case 2: CopyChannel<2>(src, plane, count); break;
+			case 3: CopyChannel<3>(src, plane, count); break;
+			case 4: CopyChannel<4>(src, plane, count); break;
+			default: std::fill(plane, plane + count, opaque); break;
+			}
+		}
+		stbi_image_free(data);
+		return plane;
+	}
+}
+
+unsigned char* ImageLoader::LoadGrayscale(const std::string& path, int& width, int& height, SourceChannel channel)
+{
+	unsigned char* data = LoadChannel(path, width, height, channel);
+	if(!data) std::cerr << "Failed to load: " << path << "\n";
+
+	return data;
+}
+
+unsigned char* ImageLoader::LoadChannel(const std::string& path, int& width, int& height, SourceChannel channel)
+{
+	return LoadPlane<unsigned char>(path, width, height, channel, 255);
+}
+
+uint16_t* ImageLoader::LoadChannel16(const std::string& path, int& width, int& height, SourceChannel channel)
+{
+	return LoadPlane<uint16_t>(path, width, height, channel, 65535);
+}
+
+bool ImageLoader::ParseChannel(const std::string& name, SourceChannel& channel)
+{
+	std::string lower(name);
+	std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+	if(lower == "luma" || lower == "gray" || lower == "grey") channel = SourceChannel::Luma;
+	else if(lower == "r" || lower == "red") channel = SourceChannel::Red;
+	else if(lower == "g" || lower == "green") channel = SourceChannel::Green;
+	else if(lower == "b" || lower == "blue") channel = SourceChannel::Blue;
+	else if(lower == "a" || lower == "alpha") channel = SourceChannel::Alpha;
+	else return false;
+
+	return true;
+}
+
+bool ImageLoader::GetInfo(const std::string& path, int& width, int& height, int& channels)
+{
+	const MappedFile file(path);
+	if(!file.IsOpen() || file.GetSize() > static_cast<size_t>(INT_MAX))
+	{
+		return false;
+	}
+
+	return stbi_info_from_memory(file.GetData(), static_cast<int>(file.GetSize()), &width, &height, &channels) != 0;
+}
+
+bool ImageLoader::Is16Bit(const std::string& path)
+{
+	const MappedFile file(path);
+	if(!file.IsOpen() || file.GetSize() > static_cast<size_t>(INT_MAX))
+	{
+		return false;
+	}
+
+	return stbi_is_16_bit_from_memory(file.GetData(), static_cast<int>(file.GetSize())) != 0;
+}
+
+void ImageLoader::Free(void* pixels)
+{
+	stbi_image_free(pixels);
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "Types.h"
+
+/**
+ * ImageLoader
+ *
+ * Decodes input images straight from a MappedFile: common PNGs through PngReader, everything
+ * else with stb_image. This is the only translation unit that compiles the stb_image
+ * implementation; pixels it returns must be released with Free.
+ */
+class ImageLoader
+{
+public:
+	/** Decodes path into desiredChannels (0 = as stored) 8-bit channels; channels receives the stored count. */
+	static unsigned char* Load(const std::string& path, int& width, int& height, int& channels, int desiredChannels);
+
+	/** Load with 16-bit channels in host byte order; 8-bit sources are widened (v * 257). */
+	static uint16_t* Load16(const std::string& path, int& width, int& height, int& channels, int desiredChannels);
+
+	/** Decodes path as a single 8-bit channel, reporting failures on stderr. */
+	static unsigned char* LoadGrayscale(const std::string& path, int& width, int& height, SourceChannel channel = SourceChannel::Luma);
+
+	/**
+	 * Decodes one 8-bit plane. Gray sources are returned as decoded, without any per-pixel pass;
+	 * a color channel is copied straight out of the decoded scanlines instead of being mixed into luma.
+	 */
+	static unsigned char* LoadChannel(const std::string& path, int& width, int& height, SourceChannel channel);
+
+	/** LoadChannel with 16-bit samples, as Load16 returns them. */
+	static uint16_t* LoadChannel16(const std::string& path, int& width, int& height, SourceChannel channel);
+
+	/** Parses "luma", "r", "g", "b", "a" or the full color names, case-insensitive. */
+	static bool ParseChannel(const std::string& name, SourceChannel& channel);
+
+	/** Reads only the header of path: size and stored channel count. */
+	static bool GetInfo(const std::string& path, int& width, int& height, int& channels);
+
+	/** True when path stores 16-bit samples, from its header alone. */
+	static bool Is16Bit(const std::string& path);
+
+	static void Free(void* pixels);
+};
@@ -0,0 +1,161 @@
+#include "MappedFile.h"
+
+#include <utility>
+
+#ifdef _WIN32
+	#ifndef NOMINMAX
+		#define NOMINMAX
+	#endif
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(const std::string& path)
+{
+	Open(path);
+}
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+{
+	*this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+	if(this != &other)
+	{
+		Close();
+		data = std::exchange(other.data, nullptr);
+		size = std::exchange(other.size, 0);
+#ifdef _WIN32
+		mapping = std::exchange(other.mapping, nullptr);
+#endif
+	}
+	return *this;
+}
+
+#ifdef _WIN32
+
+bool MappedFile::Open(const std::string& path)
+{
+	Close();
+
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if(file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER fileSize{};
+	if(!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart <= 0)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	// the view keeps the section alive, the file handle is not needed past this point
+	mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	CloseHandle(file);
+	if(!mapping)
+	{
+		return false;
+	}
+
+	data = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+	if(!data)
+	{
+		CloseHandle(mapping);
+		mapping = nullptr;
+		return false;
+	}
+
+	size = static_cast<size_t>(fileSize.QuadPart);
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if(data)
+	{
+		UnmapViewOfFile(data);
+	}
+	if(mapping)
+	{
+		CloseHandle(mapping);
+	}
+	data = nullptr;
+	mapping = nullptr;
+	size = 0;
+}
+
+#else
+
+bool MappedFile::Open(const std::string& path)
+{
+	Close();
+
+	const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if(fd < 0)
+	{
+		return false;
+	}
+
+	struct stat info{};
+	if(fstat(fd, &info) != 0 || info.st_size <= 0)
+	{
+		close(fd);
+		return false;
+	}
+
+	void* view = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if(view == MAP_FAILED)
+	{
+		return false;
+	}
+
+	// decoders read the file front to back exactly once, so ask for aggressive read-ahead
+	madvise(view, static_cast<size_t>(info.st_size), MADV_SEQUENTIAL);
+	madvise(view, static_cast<size_t>(info.st_size), MADV_WILLNEED);
+
+	data = static_cast<const uint8_t*>(view);
+	size = static_cast<size_t>(info.st_size);
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if(data)
+	{
+		munmap(const_cast<uint8_t*>(data), size);
+	}
+	data = nullptr;
+	size = 0;
+}
+
+#endif
+
+bool MappedFile::IsOpen() const
+{
+	return data != nullptr;
+}
+
+const uint8_t* MappedFile::GetData() const
+{
+	return data;
+}
+
+size_t MappedFile::GetSize() const
+{
+	return size;
+}
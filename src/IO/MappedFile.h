@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * MappedFile
+ *
+ * Read-only memory mapping of a whole file, used to decode inputs straight from the page
+ * cache instead of copying them through stdio buffers. The mapping is hinted for a single
+ * sequential pass. Move-only; the view is released on destruction.
+ */
+class MappedFile
+{
+public:
+	MappedFile() = default;
+	explicit MappedFile(const std::string& path);
+	~MappedFile();
+
+	MappedFile(MappedFile&& other) noexcept;
+	MappedFile& operator=(MappedFile&& other) noexcept;
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	/** Maps path, releasing any previous mapping. Empty or unreadable files fail. */
+	bool Open(const std::string& path);
+	void Close();
+
+	bool IsOpen() const;
+	const uint8_t* GetData() const;
+	size_t GetSize() const;
+
+private:
+	const uint8_t* data = nullptr;
+	size_t size = 0;
+#ifdef _WIN32
+	void* mapping = nullptr;
+#endif
+};
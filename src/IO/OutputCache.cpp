@@ -0,0 +1,135 @@
+#include "OutputCache.h"
+#include "ContentHash.h"
+
+#include <random>
+#include <system_error>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+	// bump whenever the packer or the encoder start producing different bytes for the same input
+	constexpr uint64_t FormatVersion = 1;
+
+	bool IsRequested(bool generate, const std::string& path)
+	{
+		return generate && !path.empty();
+	}
+
+	bool HasSameContent(const fs::path& a, const fs::path& b)
+	{
+		std::error_code error;
+		const uintmax_t size = fs::file_size(a, error);
+		if(error || size != fs::file_size(b, error) || error)
+		{
+			return false;
+		}
+
+		uint64_t hashA = 0, hashB = 0;
+		return ContentHash::HashFile(a.string(), hashA) && ContentHash::HashFile(b.string(), hashB) && hashA == hashB;
+	}
+
+	bool RestoreOutput(const fs::path& entry, const std::string& destination)
+	{
+		std::error_code error;
+		if(!fs::is_regular_file(entry, error))
+		{
+			return false;
+		}
+
+		if(HasSameContent(entry, destination))
+		{
+			return true;
+		}
+
+		return fs::copy_file(entry, destination, fs::copy_options::overwrite_existing, error);
+	}
+
+	void StoreOutput(const std::string& source, const fs::path& entry)
+	{
+		std::error_code error;
+		if(fs::exists(entry, error))
+		{
+			return;
+		}
+
+		// copied under a random name and renamed, so concurrent jobs and processes never see a partial entry
+		fs::path temporary = entry;
+		temporary += "." + ContentHash::ToHex(std::random_device()()) + ".tmp";
+		if(fs::copy_file(source, temporary, fs::copy_options::overwrite_existing, error))
+		{
+			fs::rename(temporary, entry, error);
+		}
+		if(error)
+		{
+			fs::remove(temporary, error);
+		}
+	}
+}
+
+OutputCache::OutputCache(const SaveData& job)
+	: job(job)
+	, directory(job.cacheDirectory)
+{
+	if(directory.empty())
+	{
+		return;
+	}
+
+	uint64_t key[8] = { FormatVersion };
+	if(!ContentHash::HashFile(job.ao, key[1]) || !ContentHash::HashFile(job.rough, key[2]) || !ContentHash::HashFile(job.metal, key[3]))
+	{
+		return;
+	}
+	key[4] = static_cast<uint64_t>(job.targetResolution);
+	key[5] = static_cast<uint64_t>(job.pngOptions.compression) | static_cast<uint64_t>(job.pngOptions.bitDepth) << 8;
+	key[6] = (job.streaming ? 1 : 0) | (job.dither ? 2 : 0);		// the band partition differs, so do the compressed bytes
+	key[7] = static_cast<uint64_t>(job.aoChannel) | static_cast<uint64_t>(job.roughChannel) << 8 | static_cast<uint64_t>(job.metalChannel) << 16;
+
+	// one key per layout, so a job asking for a single layout shares entries with one asking for both
+	unrealKey = ContentHash::Hash(key, sizeof(key), 'R');
+	unityKey = ContentHash::Hash(key, sizeof(key), 'U');
+	valid = true;
+}
+
+bool OutputCache::IsValid() const
+{
+	return valid;
+}
+
+bool OutputCache::Restore() const
+{
+	if(!valid)
+	{
+		return false;
+	}
+
+	const bool doUnreal = IsRequested(job.generateUnreal, job.saveUnrealPath);
+	const bool doUnity = IsRequested(job.generateUnity, job.saveUnityPath);
+	return (!doUnreal || RestoreOutput(GetEntryPath(unrealKey), job.saveUnrealPath))
+		&& (!doUnity || RestoreOutput(GetEntryPath(unityKey), job.saveUnityPath));
+}
+
+void OutputCache::Store() const
+{
+	if(!valid)
+	{
+		return;
+	}
+
+	std::error_code error;
+	fs::create_directories(directory, error);
+	if(IsRequested(job.generateUnreal, job.saveUnrealPath))
+	{
+		StoreOutput(job.saveUnrealPath, GetEntryPath(unrealKey));
+	}
+	if(IsRequested(job.generateUnity, job.saveUnityPath))
+	{
+		StoreOutput(job.saveUnityPath, GetEntryPath(unityKey));
+	}
+}
+
+fs::path OutputCache::GetEntryPath(uint64_t key) const
+{
+	return directory / (ContentHash::ToHex(key) + ".png");
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+
+#include "Types.h"
+
+/**
+ * OutputCache
+ *
+ * Content-addressed store of generated ORM files. The key of an output is the XXH64 of the
+ * three input files plus every setting that changes its bytes (source channels, layout,
+ * resolution, encoder mode), so renamed or touched inputs still hit and edited ones always miss. Entries are plain
+ * PNG copies named by key inside SaveData::cacheDirectory; they are never hardlinked to the
+ * outputs, which the PNG writers truncate in place.
+ */
+class OutputCache
+{
+public:
+	/** Hashes the inputs of job. IsValid() is false when the job has no cache directory or an input cannot be read. */
+	explicit OutputCache(const SaveData& job);
+
+	bool IsValid() const;
+
+	/**
+	 * Brings every requested output up to date from the cache; a destination that already holds
+	 * the cached bytes is left untouched. Returns false on any miss.
+	 */
+	bool Restore() const;
+
+	/** Adds the freshly written outputs; failures only cost a later cache miss. */
+	void Store() const;
+
+private:
+	std::filesystem::path GetEntryPath(uint64_t key) const;
+
+	const SaveData& job;
+	std::filesystem::path directory;
+	uint64_t unrealKey = 0;
+	uint64_t unityKey = 0;
+	bool valid = false;
+};
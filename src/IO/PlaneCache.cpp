@@ -0,0 +1,277 @@
+#include "PlaneCache.h"
+#include "ContentHash.h"
+#include "FileWatcher.h"
+#include "ImageLoader.h"
+#include "PlaneStore.h"
+#include "ThreadPool.h"
+
+#include <exception>
+#include <filesystem>
+#include <iostream>
+#include <system_error>
+#include <utility>
+
+Plane::Plane(void* pixels, int width, int height, int channels, int bytesPerChannel)
+	: decoded(pixels)
+	, pixels(static_cast<const unsigned char*>(pixels))
+	, width(width)
+	, height(height)
+	, channels(channels)
+	, bytesPerChannel(bytesPerChannel)
+{
+}
+
+Plane::Plane(MappedFile mapping, size_t offset, int width, int height, int channels, int bytesPerChannel)
+	: mapping(std::move(mapping))
+	, width(width)
+	, height(height)
+	, channels(channels)
+	, bytesPerChannel(bytesPerChannel)
+{
+	pixels = this->mapping.GetData() + offset;
+}
+
+Plane::~Plane()
+{
+	ImageLoader::Free(decoded);
+}
+
+const unsigned char* Plane::GetPixels() const
+{
+	return pixels;
+}
+
+int Plane::GetWidth() const
+{
+	return width;
+}
+
+int Plane::GetHeight() const
+{
+	return height;
+}
+
+int Plane::GetChannels() const
+{
+	return channels;
+}
+
+int Plane::GetBytesPerChannel() const
+{
+	return bytesPerChannel;
+}
+
+size_t Plane::GetSize() const
+{
+	return static_cast<size_t>(width) * height * channels * bytesPerChannel;
+}
+
+PlaneCache& PlaneCache::Get()
+{
+	static PlaneCache instance;
+	return instance;
+}
+
+void PlaneCache::SetBudget(size_t bytes)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	budget = bytes;
+	Evict();
+}
+
+size_t PlaneCache::GetBudget() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return budget;
+}
+
+void PlaneCache::SetStoreDirectory(const std::string& directory)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	storeDirectory = directory;
+}
+
+PlaneHandle PlaneCache::Load(const std::string& path, int channels)
+{
+	return Fetch(path, channels, SourceChannel::Luma, 8);
+}
+
+PlaneHandle PlaneCache::LoadGrayscale(const std::string& path, SourceChannel channel, int bitDepth)
+{
+	PlaneHandle plane = Fetch(path, 1, channel, bitDepth);
+	if(!plane) std::cerr << "Failed to load: " << path << "\n";
+
+	return plane;
+}
+
+PlaneHandle PlaneCache::Fetch(const std::string& path, int channels, SourceChannel source, int bitDepth)
+{
+	if(channels != 1)
+	{
+		source = SourceChannel::Luma;
+		bitDepth = 8;
+	}
+
+	// size and write time are part of the key, so a re-exported file never returns stale pixels
+	std::error_code error;
+	const std::string normalized = FileWatcher::NormalizePath(path);
+	const uintmax_t fileSize = std::filesystem::file_size(normalized, error);
+	if(error)
+	{
+		return nullptr;
+	}
+	const auto writeTime = std::filesystem::last_write_time(normalized, error).time_since_epoch().count();
+	const std::string key = normalized + '|' + std::to_string(fileSize) + '|' + std::to_string(writeTime) + '|' + std::to_string(channels)
+		+ '|' + std::to_string(static_cast<int>(source)) + '|' + std::to_string(bitDepth);
+
+	std::promise<PlaneHandle> decoded;
+	std::string store;
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		auto found = entries.find(key);
+		if(found != entries.end())
+		{
+			recentKeys.splice(recentKeys.begin(), recentKeys, found->second.recent);
+			std::shared_future<PlaneHandle> plane = found->second.plane;
+			lock.unlock();
+
+			// a pool worker keeps the queue moving instead of parking on the decode; other threads
+			// (the UI) just block, so they never pick up a whole queued job
+			ThreadPool& pool = ThreadPool::Get();
+			if(pool.IsWorkerThread())
+			{
+				pool.Wait(plane);
+			}
+			return plane.get();
+		}
+
+		store = storeDirectory;
+		if(budget == 0)
+		{
+			lock.unlock();
+			return Decode(normalized, channels, source, bitDepth, store);
+		}
+
+		// published before decoding, so concurrent requests for the same file wait on this one
+		recentKeys.push_front(key);
+		Entry& entry = entries[key];
+		entry.plane = decoded.get_future().share();
+		entry.recent = recentKeys.begin();
+	}
+
+	PlaneHandle plane;
+	try
+	{
+		plane = Decode(normalized, channels, source, bitDepth, store);
+	}
+	catch(...)
+	{
+		// waiters get the same exception, and the next request decodes again
+		decoded.set_exception(std::current_exception());
+		std::lock_guard<std::mutex> lock(mutex);
+		auto found = entries.find(key);
+		if(found != entries.end() && found->second.size == 0)
+		{
+			recentKeys.erase(found->second.recent);
+			entries.erase(found);
+		}
+		throw;
+	}
+	decoded.set_value(plane);
+
+	std::lock_guard<std::mutex> lock(mutex);
+	auto found = entries.find(key);
+	if(found != entries.end() && found->second.size == 0)
+	{
+		if(plane)
+		{
+			found->second.size = plane->GetSize();
+			cachedBytes += found->second.size;
+			Evict();
+		}
+		else
+		{
+			// failures are not cached; the file may be complete on the next attempt
+			recentKeys.erase(found->second.recent);
+			entries.erase(found);
+		}
+	}
+	return plane;
+}
+
+void PlaneCache::Clear()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	for(auto it = entries.begin(); it != entries.end();)
+	{
+		// entries still being decoded belong to their loader
+		if(it->second.size == 0)
+		{
+			++it;
+			continue;
+		}
+		recentKeys.erase(it->second.recent);
+		it = entries.erase(it);
+	}
+	cachedBytes = 0;
+}
+
+PlaneHandle PlaneCache::Decode(const std::string& path, int channels, SourceChannel source, int bitDepth, const std::string& storeDirectory)
+{
+	const int bytesPerChannel = bitDepth == 16 ? 2 : 1;
+
+	// Hashing the compressed file is far cheaper than inflating it, so the store is checked first
+	uint64_t contentHash = 0;
+	const bool useStore = !storeDirectory.empty() && ContentHash::HashFile(path, contentHash);
+	if(useStore)
+	{
+		if(PlaneHandle plane = PlaneStore::Open(storeDirectory, contentHash, channels, source, bytesPerChannel))
+		{
+			return plane;
+		}
+	}
+
+	int width = 0, height = 0, stored = 0;
+	void* pixels = nullptr;
+	if(channels != 1)
+	{
+		pixels = ImageLoader::Load(path, width, height, stored, channels);
+	}
+	else if(bytesPerChannel == 2)
+	{
+		pixels = ImageLoader::LoadChannel16(path, width, height, source);
+	}
+	else
+	{
+		pixels = ImageLoader::LoadChannel(path, width, height, source);
+	}
+	if(!pixels)
+	{
+		return nullptr;
+	}
+
+	PlaneHandle plane = std::make_shared<const Plane>(pixels, width, height, channels, bytesPerChannel);
+	if(useStore)
+	{
+		PlaneStore::Save(storeDirectory, contentHash, source, *plane);
+	}
+	return plane;
+}
+
+void PlaneCache::Evict()
+{
+	auto it = recentKeys.end();
+	while(cachedBytes > budget && it != recentKeys.begin())
+	{
+		--it;
+		auto found = entries.find(*it);
+		if(found->second.size == 0)
+		{
+			continue;
+		}
+
+		cachedBytes -= found->second.size;
+		entries.erase(found);
+		it = recentKeys.erase(it);
+	}
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "MappedFile.h"
+#include "Types.h"
+
+/** A decoded image, immutable once published; shared read-only by every holder of a handle. */
+class Plane
+{
+public:
+	/** Takes ownership of pixels returned by ImageLoader; 2 bytes per channel = host-order uint16_t. */
+	Plane(void* pixels, int width, int height, int channels, int bytesPerChannel = 1);
+
+	/** Pixels that live inside a mapped PlaneStore file, offset bytes from its start. */
+	Plane(MappedFile mapping, size_t offset, int width, int height, int channels, int bytesPerChannel = 1);
+	~Plane();
+
+	Plane(const Plane&) = delete;
+	Plane& operator=(const Plane&) = delete;
+
+	const unsigned char* GetPixels() const;
+	int GetWidth() const;
+	int GetHeight() const;
+	int GetChannels() const;
+	int GetBytesPerChannel() const;
+	size_t GetSize() const;
+
+private:
+	void* decoded = nullptr;				// owned stb_image buffer, or null when mapped
+	MappedFile mapping;
+	const unsigned char* pixels = nullptr;
+	int width = 0;
+	int height = 0;
+	int channels = 0;
+	int bytesPerChannel = 1;
+};
+
+using PlaneHandle = std::shared_ptr<const Plane>;
+
+/**
+ * PlaneCache
+ *
+ * Process-wide, byte-budgeted LRU cache of decoded inputs shared by the UI thumbnails, the
+ * generator and batch jobs. Entries are keyed by normalized path, size, modification time and
+ * decoded format, so a rewritten file is decoded again. Callers get ref-counted handles: an
+ * evicted plane stays alive until its last user drops it, and a plane requested while another
+ * thread is still decoding it is waited for instead of being decoded twice. Misses go through
+ * the on-disk PlaneStore first when one is configured.
+ */
+class PlaneCache
+{
+public:
+	static constexpr size_t DefaultBudget = size_t(512) * 1024 * 1024;
+
+	static PlaneCache& Get();
+
+	/** Bytes of decoded pixels kept for reuse; 0 disables caching. Shrinking evicts at once. */
+	void SetBudget(size_t bytes);
+	size_t GetBudget() const;
+
+	/** Directory of a PlaneStore shared with other processes; empty (the default) decodes every miss. */
+	void SetStoreDirectory(const std::string& directory);
+
+	/** Decoded path with the given channel count (1-4), or null if it cannot be read. */
+	PlaneHandle Load(const std::string& path, int channels);
+
+	/**
+	 * Single-channel decode of the given source channel, reporting failures on stderr like ImageLoader::LoadGrayscale.
+	 * bitDepth 16 keeps 16-bit sources intact (ImageLoader::LoadChannel16).
+	 */
+	PlaneHandle LoadGrayscale(const std::string& path, SourceChannel channel = SourceChannel::Luma, int bitDepth = 8);
+
+	void Clear();
+
+private:
+	struct Entry
+	{
+		std::shared_future<PlaneHandle> plane;
+		size_t size = 0;							// 0 while decoding
+		std::list<std::string>::iterator recent;
+	};
+
+	PlaneCache() = default;
+
+	/** Cached decode; source and 16-bit depth only apply to single-channel planes. */
+	PlaneHandle Fetch(const std::string& path, int channels, SourceChannel source, int bitDepth);
+
+	/** Maps path from the store, or decodes it and adds it there. */
+	static PlaneHandle Decode(const std::string& path, int channels, SourceChannel source, int bitDepth, const std::string& storeDirectory);
+
+	/** Drops least recently used planes until the budget holds. Requires mutex. */
+	void Evict();
+
+	mutable std::mutex mutex;
+	std::map<std::string, Entry> entries;
+	std::list<std::string> recentKeys;		// front = most recently used
+	size_t budget = DefaultBudget;
+	size_t cachedBytes = 0;
+	std::string storeDirectory;
+};
@@ -0,0 +1,102 @@
+#include "PlaneStore.h"
+#include "ContentHash.h"
+#include "MappedFile.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+	constexpr char Magic[8] = { 'O', 'R', 'M', 'P', 'L', 'A', 'N', 'E' };
+	constexpr uint32_t FormatVersion = 1;
+
+	/** Little-endian, native layout; the store is a cache, not an interchange format. */
+	struct Header
+	{
+		char magic[8];
+		uint32_t version;
+		uint32_t width;
+		uint32_t height;
+		uint32_t channels;
+		uint32_t bytesPerChannel;
+		uint32_t source;			// SourceChannel of single-channel planes
+		uint64_t contentHash;
+	};
+	static_assert(sizeof(Header) <= PlaneStore::HeaderSize, "header must fit in front of the pixels");
+
+	fs::path GetPlanePath(const std::string& directory, uint64_t contentHash, int channels, int bytesPerChannel, SourceChannel source)
+	{
+		const uint64_t key[4] = { contentHash, static_cast<uint64_t>(channels), static_cast<uint64_t>(bytesPerChannel), static_cast<uint64_t>(source) };
+		return fs::path(directory) / (ContentHash::ToHex(ContentHash::Hash(key, sizeof(key))) + ".plane");
+	}
+}
+
+PlaneHandle PlaneStore::Open(const std::string& directory, uint64_t contentHash, int channels, SourceChannel source, int bytesPerChannel)
+{
+	const fs::path path = GetPlanePath(directory, contentHash, channels, bytesPerChannel, source);
+	std::error_code error;
+	if(!fs::is_regular_file(path, error))
+	{
+		return nullptr;
+	}
+
+	MappedFile file;
+	if(!file.Open(path.string()) || file.GetSize() < HeaderSize)
+	{
+		return nullptr;
+	}
+
+	Header header;
+	std::memcpy(&header, file.GetData(), sizeof(header));
+	const size_t pixelBytes = static_cast<size_t>(header.width) * header.height * header.channels * header.bytesPerChannel;
+	if(std::memcmp(header.magic, Magic, sizeof(Magic)) != 0 || header.version != FormatVersion
+		|| header.contentHash != contentHash || header.channels != static_cast<uint32_t>(channels) || header.bytesPerChannel != static_cast<uint32_t>(bytesPerChannel)
+		|| header.source != static_cast<uint32_t>(source)
+		|| header.width == 0 || header.height == 0 || file.GetSize() != HeaderSize + pixelBytes)
+	{
+		return nullptr;
+	}
+
+	return std::make_shared<const Plane>(std::move(file), HeaderSize, static_cast<int>(header.width), static_cast<int>(header.height), channels, bytesPerChannel);
+}
+
+void PlaneStore::Save(const std::string& directory, uint64_t contentHash, SourceChannel source, const Plane& plane)
+{
+	std::error_code error;
+	fs::create_directories(directory, error);
+
+	const fs::path path = GetPlanePath(directory, contentHash, plane.GetChannels(), plane.GetBytesPerChannel(), source);
+	fs::path temporary = path;
+	temporary += "." + ContentHash::ToHex(std::random_device()()) + ".tmp";
+
+	std::vector<char> header(HeaderSize, 0);
+	Header fields = { {}, FormatVersion, static_cast<uint32_t>(plane.GetWidth()),
+		static_cast<uint32_t>(plane.GetHeight()), static_cast<uint32_t>(plane.GetChannels()), static_cast<uint32_t>(plane.GetBytesPerChannel()), static_cast<uint32_t>(source), contentHash };
+	std::memcpy(fields.magic, Magic, sizeof(Magic));
+	std::memcpy(header.data(), &fields, sizeof(fields));
+
+	bool written = false;
+	{
+		std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+		file.write(header.data(), static_cast<std::streamsize>(header.size()));
+		file.write(reinterpret_cast<const char*>(plane.GetPixels()), static_cast<std::streamsize>(plane.GetSize()));
+		written = static_cast<bool>(file);
+	}
+
+	// another process may have stored the same plane meanwhile; either copy is complete
+	if(written)
+	{
+		fs::rename(temporary, path, error);
+	}
+	if(!written || error)
+	{
+		fs::remove(temporary, error);
+	}
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "PlaneCache.h"
+
+/**
+ * PlaneStore
+ *
+ * On-disk store of decoded planes shared between processes. Each plane is one uncompressed
+ * file named after the XXH64 of the source file and the decoded format (channel count, sample
+ * size and selected source channel): a header padded to
+ * HeaderSize, then the rows, so the pixels start page aligned and a later run maps them
+ * directly instead of inflating the PNG again. Files are written under a private name and
+ * renamed into place, so readers only ever see complete planes.
+ */
+class PlaneStore
+{
+public:
+	/** Pixels start at this offset; a multiple of every common page size. */
+	static constexpr size_t HeaderSize = 4096;
+
+	/** Maps the plane decoded from content with contentHash, or null if the store does not have it. */
+	static PlaneHandle Open(const std::string& directory, uint64_t contentHash, int channels, SourceChannel source, int bytesPerChannel = 1);
+
+	/** Writes plane to the store; failures only cost a later decode. */
+	static void Save(const std::string& directory, uint64_t contentHash, SourceChannel source, const Plane& plane);
+};
@@ -0,0 +1,14 @@
+#pragma once
+
+enum class PngCompression : int
+{
+	Default,	// adaptive per-row filter, hash-chain deflate with lazy matching
+	Fast		// fixed Up filter, single-probe greedy deflate; for iteration builds
+};
+
+struct PngWriteOptions
+{
+	PngCompression compression = PngCompression::Default;
+	unsigned int workerCount = 0;	// threads used for the bands, 0 = the whole pool
+	int bitDepth = 8;				// 8, or 16 with every sample stored big-endian, as PNG orders it
+};
@@ -0,0 +1,229 @@
+#include "PngReader.h"
+#include "UnfilterKernels.h"
+
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include <stb_image.h>
+
+namespace
+{
+	constexpr uint8_t Signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+
+	uint32_t ReadBigEndian32(const uint8_t* p)
+	{
+		return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) | (static_cast<uint32_t>(p[2]) << 8) | p[3];
+	}
+
+	bool IsChunk(const uint8_t* type, const char* name)
+	{
+		return std::memcmp(type, name, 4) == 0;
+	}
+
+	int ChannelsOfColorType(uint8_t colorType)
+	{
+		switch(colorType)
+		{
+		case 0: return 1;	// gray
+		case 2: return 3;	// RGB
+		case 4: return 2;	// gray + alpha
+		case 6: return 4;	// RGBA
+		default: return 0;	// palette and invalid types go to stb_image
+		}
+	}
+
+	struct FreeDeleter
+	{
+		void operator()(void* p) const { std::free(p); }
+	};
+}
+
+bool PngReader::IsPng(const uint8_t* data, size_t size)
+{
+	return size >= sizeof(Signature) && std::memcmp(data, Signature, sizeof(Signature)) == 0;
+}
+
+namespace
+{
+	/** Decodes into outputBytes (1 or 2) per sample; 2 = host-order uint16_t, for 16-bit files only. */
+	uint8_t* DecodeSamples(const uint8_t* data, size_t size, int& width, int& height, int& channels, size_t outputBytes)
+	{
+		if(!PngReader::IsPng(data, size))
+		{
+			return nullptr;
+		}
+
+		uint32_t imageWidth = 0, imageHeight = 0;
+		int bitDepth = 0;
+		int imageChannels = 0;
+
+		// Most encoders split the stream into many IDAT chunks; a single one is inflated in place
+		const uint8_t* idat = nullptr;
+		size_t idatSize = 0;
+		std::vector<uint8_t> joinedIdat;
+		bool sawEnd = false;
+
+		size_t offset = sizeof(Signature);
+		while(offset + 12 <= size && !sawEnd)
+		{
+			const uint32_t length = ReadBigEndian32(data + offset);
+			const uint8_t* type = data + offset + 4;
+			const uint8_t* payload = data + offset + 8;
+			if(length > size - offset - 12)
+			{
+				return nullptr;
+			}
+
+			if(IsChunk(type, "IHDR"))
+			{
+				if(length != 13)
+				{
+					return nullptr;
+				}
+				imageWidth = ReadBigEndian32(payload);
+				imageHeight = ReadBigEndian32(payload + 4);
+				bitDepth = payload[8];
+				imageChannels = ChannelsOfColorType(payload[9]);
+				const bool interlaced = payload[12] != 0;
+				if(imageChannels == 0 || (bitDepth != 8 && bitDepth != 16) || interlaced || payload[10] != 0 || payload[11] != 0)
+				{
+					return nullptr;
+				}
+				if(outputBytes > static_cast<size_t>(bitDepth / 8))
+				{
+					return nullptr;
+				}
+			}
+			else if(IsChunk(type, "IDAT"))
+			{
+				if(idat && joinedIdat.empty())
+				{
+					joinedIdat.assign(idat, idat + idatSize);
+				}
+				if(idat)
+				{
+					joinedIdat.insert(joinedIdat.end(), payload, payload + length);
+				}
+				else
+				{
+					idat = payload;
+					idatSize = length;
+				}
+			}
+			else if(IsChunk(type, "tRNS") || IsChunk(type, "CgBI"))
+			{
+				// color-key transparency adds an alpha channel and CgBI is Apple's variant; both are stb's job
+				return nullptr;
+			}
+			else if(IsChunk(type, "IEND"))
+			{
+				sawEnd = true;
+			}
+
+			offset += 12 + static_cast<size_t>(length);
+		}
+
+		if(!imageWidth || !imageHeight || !idat || imageWidth > (1u << 24) || imageHeight > (1u << 24))
+		{
+			return nullptr;
+		}
+		if(!joinedIdat.empty())
+		{
+			idat = joinedIdat.data();
+			idatSize = joinedIdat.size();
+		}
+
+		const size_t bytesPerSample = static_cast<size_t>(bitDepth / 8);
+		const size_t bpp = static_cast<size_t>(imageChannels) * bytesPerSample;
+		const size_t rowBytes = static_cast<size_t>(imageWidth) * bpp;
+		const size_t filteredSize = (rowBytes + 1) * imageHeight;
+		if(filteredSize > static_cast<size_t>(INT_MAX) || idatSize > static_cast<size_t>(INT_MAX))
+		{
+			return nullptr;
+		}
+
+		std::unique_ptr<uint8_t, FreeDeleter> filtered(static_cast<uint8_t*>(std::malloc(filteredSize)));
+		if(!filtered)
+		{
+			return nullptr;
+		}
+
+		const int inflated = stbi_zlib_decode_buffer(reinterpret_cast<char*>(filtered.get()), static_cast<int>(filteredSize),
+			reinterpret_cast<const char*>(idat), static_cast<int>(idatSize));
+		if(inflated != static_cast<int>(filteredSize))
+		{
+			return nullptr;
+		}
+		std::vector<uint8_t>().swap(joinedIdat);
+
+		// Everything happens inside the inflated buffer, which is then shrunk: a second image-sized
+		// allocation would cost as much in first-touch page faults as the unfiltering itself.
+		// 8-bit rows are unfiltered into their final, packed place, which never overtakes the
+		// filtered bytes still to be read; 16-bit rows are unfiltered where they are.
+		const std::vector<uint8_t> zeroRow(rowBytes, 0);
+		const uint8_t* prev = zeroRow.data();
+		for(uint32_t y = 0; y < imageHeight; ++y)
+		{
+			uint8_t* const filteredRow = filtered.get() + y * (rowBytes + 1);
+			uint8_t* const row = bytesPerSample == 1 ? filtered.get() + y * rowBytes : filteredRow + 1;
+			if(!UnfilterKernels::UnfilterRow(filteredRow[0], filteredRow + 1, prev, row, rowBytes, bpp))
+			{
+				return nullptr;
+			}
+			prev = row;
+		}
+
+		const size_t samplesPerRow = static_cast<size_t>(imageWidth) * imageChannels;
+		const size_t sampleCount = samplesPerRow * imageHeight;
+		if(bytesPerSample == 2 && outputBytes == 2)
+		{
+			// swapped to host order while the rows are compacted; each write lands on bytes already read
+			for(uint32_t y = 0; y < imageHeight; ++y)
+			{
+				const uint8_t* src = filtered.get() + y * (rowBytes + 1) + 1;
+				uint16_t* dst = reinterpret_cast<uint16_t*>(filtered.get()) + y * samplesPerRow;
+				for(size_t i = 0; i < samplesPerRow; ++i)
+				{
+					dst[i] = static_cast<uint16_t>(src[i * 2] << 8 | src[i * 2 + 1]);
+				}
+			}
+		}
+		else if(bytesPerSample == 2)
+		{
+			// big-endian samples: the high byte comes first, exactly what stb keeps when it narrows to 8 bits
+			for(uint32_t y = 0; y < imageHeight; ++y)
+			{
+				const uint8_t* src = filtered.get() + y * (rowBytes + 1) + 1;
+				uint8_t* dst = filtered.get() + y * samplesPerRow;
+				for(size_t i = 0; i < samplesPerRow; ++i)
+				{
+					dst[i] = src[i * 2];
+				}
+			}
+		}
+
+		uint8_t* pixels = filtered.release();
+		if(void* shrunk = std::realloc(pixels, sampleCount * outputBytes))
+		{
+			pixels = static_cast<uint8_t*>(shrunk);
+		}
+
+		width = static_cast<int>(imageWidth);
+		height = static_cast<int>(imageHeight);
+		channels = imageChannels;
+		return pixels;
+	}
+}
+
+unsigned char* PngReader::Decode(const uint8_t* data, size_t size, int& width, int& height, int& channels)
+{
+	return DecodeSamples(data, size, width, height, channels, 1);
+}
+
+uint16_t* PngReader::Decode16(const uint8_t* data, size_t size, int& width, int& height, int& channels)
+{
+	return reinterpret_cast<uint16_t*>(DecodeSamples(data, size, width, height, channels, 2));
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * PngReader
+ *
+ * Decoder for the PNGs the tool is usually fed: non-interlaced 8 or 16-bit gray, gray+alpha,
+ * RGB and RGBA without a tRNS chunk. The IDAT stream is inflated in one call into an exactly
+ * sized buffer and the rows are reversed through UnfilterKernels; 16-bit samples are reduced to
+ * their high byte the way stb_image does, unless Decode16 keeps them. Anything else is left to
+ * stb_image.
+ */
+class PngReader
+{
+public:
+	/** True when data starts with the PNG signature. */
+	static bool IsPng(const uint8_t* data, size_t size);
+
+	/**
+	 * Decodes data as stored into 8-bit samples, allocated with malloc. Returns null when the
+	 * file is unsupported or broken; the caller then decodes it some other way.
+	 */
+	static unsigned char* Decode(const uint8_t* data, size_t size, int& width, int& height, int& channels);
+
+	/** Like Decode for 16-bit files, keeping the samples in host byte order; null for 8-bit files. */
+	static uint16_t* Decode16(const uint8_t* data, size_t size, int& width, int& height, int& channels);
+};
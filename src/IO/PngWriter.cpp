@@ -0,0 +1,362 @@
+#include "PngWriter.h"
+#include "Deflate.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+
+namespace
+{
+	constexpr uint8_t Signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+
+	enum FilterType : uint8_t
+	{
+		FilterNone = 0,
+		FilterSub = 1,
+		FilterUp = 2,
+		FilterAverage = 3,
+		FilterPaeth = 4
+	};
+
+	void PutU32(std::vector<uint8_t>& out, uint32_t value)
+	{
+		out.push_back(static_cast<uint8_t>(value >> 24));
+		out.push_back(static_cast<uint8_t>(value >> 16));
+		out.push_back(static_cast<uint8_t>(value >> 8));
+		out.push_back(static_cast<uint8_t>(value));
+	}
+
+	void AppendChunk(std::vector<uint8_t>& out, const char* type, const uint8_t* data, size_t size)
+	{
+		PutU32(out, static_cast<uint32_t>(size));
+		const size_t typeOffset = out.size();
+		out.insert(out.end(), type, type + 4);
+		out.insert(out.end(), data, data + size);
+		PutU32(out, Deflate::Crc32(out.data() + typeOffset, size + 4));
+	}
+
+	inline uint8_t PaethPredictor(int a, int b, int c)
+	{
+		const int p = a + b - c;
+		const int pa = std::abs(p - a);
+		const int pb = std::abs(p - b);
+		const int pc = std::abs(p - c);
+		if(pa <= pb && pa <= pc) return static_cast<uint8_t>(a);
+		if(pb <= pc) return static_cast<uint8_t>(b);
+		return static_cast<uint8_t>(c);
+	}
+
+	/** Applies one PNG filter to a row; out receives rowBytes residuals (without the type byte). */
+	void FilterRow(uint8_t type, const uint8_t* row, const uint8_t* prev, size_t rowBytes, size_t bpp, uint8_t* out)
+	{
+		switch(type)
+		{
+		case FilterNone:
+			std::copy(row, row + rowBytes, out);
+			break;
+		case FilterSub:
+			for(size_t i = 0; i < rowBytes; ++i)
+			{
+				out[i] = static_cast<uint8_t>(row[i] - (i >= bpp ? row[i - bpp] : 0));
+			}
+			break;
+		case FilterUp:
+			for(size_t i = 0; i < rowBytes; ++i)
+			{
+				out[i] = static_cast<uint8_t>(row[i] - prev[i]);
+			}
+			break;
+		case FilterAverage:
+			for(size_t i = 0; i < rowBytes; ++i)
+			{
+				const int left = i >= bpp ? row[i - bpp] : 0;
+				out[i] = static_cast<uint8_t>(row[i] - ((left + prev[i]) >> 1));
+			}
+			break;
+		case FilterPaeth:
+			for(size_t i = 0; i < rowBytes; ++i)
+			{
+				const int left = i >= bpp ? row[i - bpp] : 0;
+				const int upLeft = i >= bpp ? prev[i - bpp] : 0;
+				out[i] = static_cast<uint8_t>(row[i] - PaethPredictor(left, prev[i], upLeft));
+			}
+			break;
+		}
+	}
+
+	/** Writes the type byte and residuals of the filter with the smallest sum of absolute residuals. */
+	void FilterRowAdaptive(const uint8_t* row, const uint8_t* prev, size_t rowBytes, size_t bpp, uint8_t* out, uint8_t* scratch)
+	{
+		uint64_t bestCost = UINT64_MAX;
+		for(uint8_t type = FilterNone; type <= FilterPaeth; ++type)
+		{
+			FilterRow(type, row, prev, rowBytes, bpp, scratch);
+
+			uint64_t cost = 0;
+			for(size_t i = 0; i < rowBytes; ++i)
+			{
+				cost += static_cast<uint64_t>(std::abs(static_cast<int>(static_cast<int8_t>(scratch[i]))));
+			}
+
+			if(cost < bestCost)
+			{
+				bestCost = cost;
+				out[0] = type;
+				std::copy(scratch, scratch + rowBytes, out + 1);
+			}
+		}
+	}
+
+	/** Signature, IHDR and the zlib header, which sits in its own IDAT so the bands can be emitted unchanged. */
+	void AppendHeader(std::vector<uint8_t>& out, int width, int height, int channels, int bitDepth)
+	{
+		static constexpr uint8_t ColorTypes[5] = { 0, 0, 4, 2, 6 };
+
+		out.insert(out.end(), Signature, Signature + sizeof(Signature));
+
+		std::vector<uint8_t> header;
+		PutU32(header, static_cast<uint32_t>(width));
+		PutU32(header, static_cast<uint32_t>(height));
+		header.push_back(static_cast<uint8_t>(bitDepth));
+		header.push_back(ColorTypes[channels]);
+		header.push_back(0);					// deflate
+		header.push_back(0);					// adaptive filtering
+		header.push_back(0);					// no interlace
+		AppendChunk(out, "IHDR", header.data(), header.size());
+
+		// deflate, 32 KiB window
+		static constexpr uint8_t ZlibHeader[2] = { 0x78, 0x01 };
+		AppendChunk(out, "IDAT", ZlibHeader, sizeof(ZlibHeader));
+	}
+
+	void AppendTrailer(std::vector<uint8_t>& out, uint32_t adler)
+	{
+		std::vector<uint8_t> trailer;
+		PutU32(trailer, adler);
+		AppendChunk(out, "IDAT", trailer.data(), trailer.size());
+		AppendChunk(out, "IEND", nullptr, 0);
+	}
+
+	bool IsValidImage(int width, int height, int channels, const PngWriteOptions& options)
+	{
+		return width > 0 && height > 0 && channels >= 1 && channels <= 4 && (options.bitDepth == 8 || options.bitDepth == 16);
+	}
+
+	/** Bytes per sample; anything but 16 is written as 8-bit. */
+	size_t GetSampleBytes(const PngWriteOptions& options)
+	{
+		return options.bitDepth == 16 ? 2 : 1;
+	}
+}
+
+PngBandEncoder::PngBandEncoder(int width, int height, int channels, const PngWriteOptions& options)
+	: height(static_cast<size_t>(std::max(height, 0)))
+	, rowBytes(static_cast<size_t>(std::max(width, 0)) * std::clamp(channels, 1, 4) * GetSampleBytes(options))
+	, bpp(static_cast<size_t>(std::clamp(channels, 1, 4)) * GetSampleBytes(options))
+{
+	dictRows = (Deflate::WindowSize + rowBytes) / (rowBytes + 1);
+	adaptiveFilter = options.compression != PngCompression::Fast;
+	if(!adaptiveFilter)
+	{
+		params.maxChainLength = 1;
+		params.lazyMatching = false;
+		params.indexWholeMatch = false;
+	}
+}
+
+size_t PngBandEncoder::GetRowBytes() const
+{
+	return rowBytes;
+}
+
+size_t PngBandEncoder::GetBandRows() const
+{
+	return std::max<size_t>(1, BandBytes / (rowBytes + 1));
+}
+
+size_t PngBandEncoder::GetContextRows(size_t firstRow) const
+{
+	// the preset window rows plus the row their filter predicts from
+	return std::min(firstRow, dictRows + 1);
+}
+
+/**
+ * The context rows just above the band are filtered again and used as the preset window, so
+ * bands compress almost as well as a single stream while staying independent.
+ */
+PngBand PngBandEncoder::Encode(const uint8_t* rows, size_t firstRow, size_t rowCount) const
+{
+	const size_t stride = rowBytes + 1;
+	const size_t contextRows = GetContextRows(firstRow);
+	const size_t windowRows = std::min(firstRow, dictRows);
+	const size_t skippedRows = contextRows - windowRows;
+
+	std::vector<uint8_t> filtered((windowRows + rowCount) * stride);
+	std::vector<uint8_t> zeroRow(rowBytes, 0);
+	std::vector<uint8_t> scratch(rowBytes);
+
+	for(size_t r = 0; r < windowRows + rowCount; ++r)
+	{
+		const size_t index = skippedRows + r;
+		const uint8_t* row = rows + index * rowBytes;
+		const uint8_t* prev = index > 0 ? row - rowBytes : zeroRow.data();
+		uint8_t* out = filtered.data() + r * stride;
+		if(adaptiveFilter)
+		{
+			FilterRowAdaptive(row, prev, rowBytes, bpp, out, scratch.data());
+		}
+		else
+		{
+			out[0] = FilterUp;
+			FilterRow(FilterUp, row, prev, rowBytes, bpp, out + 1);
+		}
+	}
+
+	const size_t dictBytes = windowRows * stride;
+	std::vector<uint8_t> compressed;
+	compressed.reserve(filtered.size() / 2);
+	Deflate::CompressBlock(filtered.data(), dictBytes, filtered.size(), firstRow + rowCount >= height, params, compressed);
+
+	PngBand result;
+	result.filteredSize = filtered.size() - dictBytes;
+	result.adler = Deflate::Adler32(filtered.data() + dictBytes, result.filteredSize);
+	result.chunk.reserve(compressed.size() + 12);
+	AppendChunk(result.chunk, "IDAT", compressed.data(), compressed.size());
+	return result;
+}
+
+PngStreamWriter::PngStreamWriter(const std::string& path, int width, int height, int channels, const PngWriteOptions& options)
+	: encoder(width, height, channels, options)
+	, path(path)
+	, height(static_cast<size_t>(std::max(height, 0)))
+{
+	if(!IsValidImage(width, height, channels, options))
+	{
+		return;
+	}
+
+	file.open(path, std::ios::binary);
+	if(file)
+	{
+		std::vector<uint8_t> header;
+		AppendHeader(header, width, height, channels, options.bitDepth);
+		file.write(reinterpret_cast<const char*>(header.data()), static_cast<std::streamsize>(header.size()));
+	}
+}
+
+bool PngStreamWriter::IsOpen() const
+{
+	return file.is_open() && file.good();
+}
+
+const PngBandEncoder& PngStreamWriter::GetEncoder() const
+{
+	return encoder;
+}
+
+void PngStreamWriter::Commit(size_t index, PngBand band)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	pendingBands.emplace(index, std::move(band));
+
+	// flush every band that is now in order; the rest waits for its predecessors
+	for(auto it = pendingBands.find(nextBand); it != pendingBands.end(); it = pendingBands.find(nextBand))
+	{
+		const PngBand& ready = it->second;
+		file.write(reinterpret_cast<const char*>(ready.chunk.data()), static_cast<std::streamsize>(ready.chunk.size()));
+		adler = Deflate::Adler32Combine(adler, ready.adler, ready.filteredSize);
+		writtenRows += ready.filteredSize / (encoder.GetRowBytes() + 1);
+		pendingBands.erase(it);
+		++nextBand;
+	}
+}
+
+bool PngStreamWriter::Finish()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	if(!file.is_open() || !pendingBands.empty() || writtenRows != height)
+	{
+		std::cerr << "Incomplete PNG: " << path << "\n";
+		return false;
+	}
+
+	std::vector<uint8_t> trailer;
+	AppendTrailer(trailer, adler);
+	file.write(reinterpret_cast<const char*>(trailer.data()), static_cast<std::streamsize>(trailer.size()));
+	file.close();
+	if(!file)
+	{
+		std::cerr << "Failed to write PNG: " << path << "\n";
+		return false;
+	}
+	return true;
+}
+
+bool PngWriter::Encode(const uint8_t* pixels, int width, int height, int channels, std::vector<uint8_t>& out,
+	const PngWriteOptions& options)
+{
+	if(!pixels || !IsValidImage(width, height, channels, options))
+	{
+		return false;
+	}
+
+	const PngBandEncoder encoder(width, height, channels, options);
+	const size_t rowBytes = encoder.GetRowBytes();
+	const size_t bandRows = encoder.GetBandRows();
+	const size_t rows = static_cast<size_t>(height);
+	const size_t bandCount = (rows + bandRows - 1) / bandRows;
+
+	std::vector<PngBand> bands(bandCount);
+	ThreadPool::Get().ParallelFor(bandCount, [&](size_t band)
+	{
+		const size_t firstRow = band * bandRows;
+		const size_t contextRows = encoder.GetContextRows(firstRow);
+		bands[band] = encoder.Encode(pixels + (firstRow - contextRows) * rowBytes, firstRow, std::min(bandRows, rows - firstRow));
+	}, options.workerCount);
+
+	out.clear();
+	AppendHeader(out, width, height, channels, options.bitDepth);
+
+	uint32_t adler = 1;
+	for(const PngBand& band : bands)
+	{
+		out.insert(out.end(), band.chunk.begin(), band.chunk.end());
+		adler = Deflate::Adler32Combine(adler, band.adler, band.filteredSize);
+	}
+
+	AppendTrailer(out, adler);
+	return true;
+}
+
+bool PngWriter::Write(const std::string& path, const uint8_t* pixels, int width, int height, int channels,
+	const PngWriteOptions& options)
+{
+	if(!pixels || !IsValidImage(width, height, channels, options))
+	{
+		std::cerr << "Failed to encode PNG: " << path << "\n";
+		return false;
+	}
+
+	PngStreamWriter writer(path, width, height, channels, options);
+	if(!writer.IsOpen())
+	{
+		std::cerr << "Failed to write PNG: " << path << "\n";
+		return false;
+	}
+
+	const PngBandEncoder& encoder = writer.GetEncoder();
+	const size_t rowBytes = encoder.GetRowBytes();
+	const size_t bandRows = encoder.GetBandRows();
+	const size_t rows = static_cast<size_t>(height);
+	const size_t bandCount = (rows + bandRows - 1) / bandRows;
+
+	ThreadPool::Get().ParallelFor(bandCount, [&](size_t band)
+	{
+		const size_t firstRow = band * bandRows;
+		const size_t contextRows = encoder.GetContextRows(firstRow);
+		writer.Commit(band, encoder.Encode(pixels + (firstRow - contextRows) * rowBytes, firstRow, std::min(bandRows, rows - firstRow)));
+	}, options.workerCount);
+
+	return writer.Finish();
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Deflate.h"
+#include "PngOptions.h"
+
+/** One encoded band: a complete IDAT chunk plus the Adler-32 of the filtered bytes it covers. */
+struct PngBand
+{
+	std::vector<uint8_t> chunk;
+	uint32_t adler = 1;
+	size_t filteredSize = 0;
+};
+
+/**
+ * PngBandEncoder
+ *
+ * Row geometry and deflate settings of one image. Every band of rows is filtered and deflated
+ * on its own (pigz style: the rows above it are re-filtered into a 32 KiB preset window and the
+ * band ends with a sync flush) into a separate IDAT chunk, so bands can be encoded on any thread
+ * in any order and concatenated afterwards.
+ */
+class PngBandEncoder
+{
+public:
+	/** Target amount of raw image data per band. */
+	static constexpr size_t BandBytes = 1024 * 1024;
+
+	PngBandEncoder(int width, int height, int channels, const PngWriteOptions& options = {});
+
+	size_t GetRowBytes() const;
+
+	/** Rows per band that keep a band close to BandBytes of raw data. */
+	size_t GetBandRows() const;
+
+	/** Number of rows directly above firstRow that Encode expects in front of the band. */
+	size_t GetContextRows(size_t firstRow) const;
+
+	/**
+	 * Filters and deflates rows [firstRow, firstRow + rowCount). rows holds GetContextRows(firstRow)
+	 * rows of context followed by the band, GetRowBytes() apart. Safe to call concurrently.
+	 */
+	PngBand Encode(const uint8_t* rows, size_t firstRow, size_t rowCount) const;
+
+private:
+	size_t height = 0;
+	size_t rowBytes = 0;
+	size_t bpp = 0;
+	size_t dictRows = 0;
+	bool adaptiveFilter = true;
+	DeflateParams params;
+};
+
+/**
+ * PngStreamWriter
+ *
+ * Writes a PNG to disk band by band. Committed bands are written as soon as all earlier ones
+ * are and their Adler-32 values are folded into the zlib trailer, so only bands that are still
+ * out of order stay in memory.
+ */
+class PngStreamWriter
+{
+public:
+	/** Opens path and writes the signature, IHDR and zlib header. Check IsOpen() afterwards. */
+	PngStreamWriter(const std::string& path, int width, int height, int channels, const PngWriteOptions& options = {});
+
+	PngStreamWriter(const PngStreamWriter&) = delete;
+	PngStreamWriter& operator=(const PngStreamWriter&) = delete;
+
+	bool IsOpen() const;
+
+	const PngBandEncoder& GetEncoder() const;
+
+	/** Hands over band number index; bands are numbered from the top starting at 0. Thread-safe. */
+	void Commit(size_t index, PngBand band);
+
+	/** Writes the trailer once every band was committed. Returns false if the file is incomplete. */
+	bool Finish();
+
+private:
+	PngBandEncoder encoder;
+	std::ofstream file;
+	std::string path;
+	size_t height = 0;
+
+	std::mutex mutex;
+	std::map<size_t, PngBand> pendingBands;
+	size_t nextBand = 0;
+	size_t writtenRows = 0;
+	uint32_t adler = 1;
+};
+
+/**
+ * PngWriter
+ *
+ * Whole-image front end of PngBandEncoder: the bands of an in-memory image are encoded
+ * in parallel on the shared ThreadPool. Output is a standard, non-interlaced 8 or 16-bit PNG.
+ */
+class PngWriter
+{
+public:
+	/**
+	 * Encodes gray (1), gray+alpha (2), RGB (3) or RGBA (4) pixels into a PNG in memory. 16-bit
+	 * pixels (options.bitDepth) are expected big-endian, the way PackKernels' 16-bit kernels emit them.
+	 */
+	static bool Encode(const uint8_t* pixels, int width, int height, int channels, std::vector<uint8_t>& out,
+		const PngWriteOptions& options = {});
+
+	/** Encodes and writes the PNG to path, flushing bands as they complete. */
+	static bool Write(const std::string& path, const uint8_t* pixels, int width, int height, int channels,
+		const PngWriteOptions& options = {});
+};
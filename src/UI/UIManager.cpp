@@ -5,8 +5,6 @@
 
 #include <nfd.h>
 
-#include <stb_image.h>
-#include <stb_image_write.h>
 #include <iostream>
 #include <filesystem>
 #include <GLFW/glfw3.h>
@@ -14,16 +12,50 @@
 #include "backends/imgui_impl_glfw.h"
 #include "backends/imgui_impl_opengl3.h"
 #include <future>
-
-#define STB_IMAGE_RESIZE_IMPLEMENTATION
+#include <algorithm>
+
+#include "ImageLoader.h"
+#include "ORMGenerator.h"
+#include "PlaneCache.h"
+#include "Resampler.h"
+#include "ThreadPool.h"
+
+// GL 3.3 texture swizzle; the system gl.h only goes up to 1.1 on some platforms
+#ifndef GL_TEXTURE_SWIZZLE_RGBA
+	#define GL_TEXTURE_SWIZZLE_RGBA 0x8E46
+#endif
+#ifndef GL_TEXTURE_MAX_LEVEL
+	#define GL_TEXTURE_MAX_LEVEL 0x813D
+#endif
+#ifndef GL_R8
+	#define GL_R8 0x8229
+#endif
+#ifndef GL_RGB8
+	#define GL_RGB8 0x8051
+#endif
+#ifndef GL_RGBA8
+	#define GL_RGBA8 0x8058
+#endif
+
+// glTexStorage2D (GL 4.2) is not exported by the system gl.h; resolved through GLFW at first use
+#ifndef APIENTRY
+	#define APIENTRY
+#endif
+typedef void (APIENTRY* PFN_TexStorage2D)(GLenum target, GLsizei levels, GLenum internalFormat, GLsizei width, GLsizei height);
 
 namespace ORMTool
 {
 	constexpr const char* TitleProgram 	= "ORMTool";
 	constexpr const char* UnrealCBoxTitle = "Unreal";
 	constexpr const char* UnityCBoxTitle = "Unity ";
+	constexpr const char* FastEncodeCBoxTitle = "Fast";
+	constexpr const char* StreamingMenuTitle = "Low memory (streaming)";
+	constexpr const char* HighBitDepthMenuTitle = "16-bit output";
+	constexpr const char* DitherMenuTitle = "Dither 16-bit inputs";
+	constexpr const char* WatchMenuTitle = "Watch inputs";
 	constexpr const char* SavedTextureFormat = "png,jpg";
 	constexpr const float CheckboxSize  = 14.0f;
+	constexpr const int ThumbnailSize = 128;
 	constexpr const auto& WindowFlags =
 		ImGuiWindowFlags_NoResize		|
 		ImGuiWindowFlags_NoMove 		|
@@ -57,6 +89,7 @@ void UIManager::DrawUI()
 {
 	ShowMainUI();
 	UpdatePreviewIfNeeded();
+	RegenerateChangedInputs();
 }
 
 void UIManager::Render()
@@ -65,31 +98,56 @@ void UIManager::Render()
 
 void UIManager::Shutdown()
 {
+	if(generationTask.valid())
+	{
+		generationTask.wait();
+	}
+
 	aoPreview.Unload();
 	roughPreview.Unload();
 	metallicPreview.Unload();
 	ormPreview.Unload();
 }
 
-bool PreviewTexture::Load(const std::string& p)
+bool PreviewTexture::Load(const std::string& p, int maxSize)
 {
 	Unload();
 
+	// Decoded the way the generator reads inputs, so generating afterwards finds the plane in the cache
 	path = p;
-	int channels;
-	data = stbi_load(p.c_str(), &width, &height, &channels, 3);
+	const PlaneHandle plane = PlaneCache::Get().Load(p, 1);
 
-	if(!data)
+	if(!plane)
 	{
 		std::cerr << "Failed to load image: " << p << std::endl;
 		return false;
 	}
 
+	width = plane->GetWidth();
+	height = plane->GetHeight();
+
+	// Shrink to the largest size that fits maxSize, keeping the aspect ratio
+	int uploadWidth = width;
+	int uploadHeight = height;
+	std::vector<unsigned char> thumbnail;
+	if(maxSize > 0 && (width > maxSize || height > maxSize))
+	{
+		const float scale = static_cast<float>(maxSize) / std::max(width, height);
+		uploadWidth = std::max(1, static_cast<int>(width * scale + 0.5f));
+		uploadHeight = std::max(1, static_cast<int>(height * scale + 0.5f));
+		thumbnail.resize(static_cast<size_t>(uploadWidth) * uploadHeight);
+		Resampler::Resize(plane->GetPixels(), width, height, 1, thumbnail.data(), uploadWidth, uploadHeight);
+	}
+
+	// one channel on the GPU, shown as gray through the swizzle
+	const GLint gray[4] = { GL_RED, GL_RED, GL_RED, GL_ONE };
 	glGenTextures(1, &glId);
 	glBindTexture(GL_TEXTURE_2D, glId);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, uploadWidth, uploadHeight, 0, GL_RED, GL_UNSIGNED_BYTE, thumbnail.empty() ? plane->GetPixels() : thumbnail.data());
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, gray);
 
 	return true;
 }
@@ -100,174 +158,160 @@ void PreviewTexture::Unload()
 	{
 		glDeleteTextures(1, &glId);
 	}
-	if(channelR)
+	glId = 0;
+	layout = ORMLayout::UnrealRGB;
+	swizzledChannel = ORMChannel::AllRGB;
+}
+
+/** Routes the requested channel of a packed layout to RGB on the bound texture */
+static void ApplyChannelSwizzle(ORMLayout layout, ORMChannel channel)
+{
+	const bool unity = layout == ORMLayout::UnityRGBA;
+	const GLint ao = unity ? GL_GREEN : GL_RED;
+	const GLint rough = unity ? GL_ALPHA : GL_GREEN;	// Unity stores smoothness; shown as is
+	const GLint metal = unity ? GL_RED : GL_BLUE;
+
+	GLint swizzle[4] = { ao, rough, metal, GL_ONE };
+	if(channel != ORMChannel::AllRGB)
 	{
-		glDeleteTextures(1, &channelR);
+		const GLint source = channel == ORMChannel::AO_R ? ao : channel == ORMChannel::Roughness_G ? rough : metal;
+		swizzle[0] = swizzle[1] = swizzle[2] = source;
 	}
-	if(channelG)
+	glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+}
+
+void PreviewTexture::Upload(const PreviewImage& image)
+{
+	Unload();
+	if(image.levels.empty())
 	{
-		glDeleteTextures(1, &channelG);
+		return;
 	}
-	if(channelB)
+
+	path = image.path;
+	width = image.width;
+	height = image.height;
+	layout = image.layout;
+
+	const GLenum format = image.channels == 4 ? GL_RGBA : GL_RGB;
+	const GLsizei levelCount = static_cast<GLsizei>(image.levels.size());
+	glGenTextures(1, &glId);
+	glBindTexture(GL_TEXTURE_2D, glId);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+	// Immutable storage holds exactly the levels handed over, not the full-resolution chain
+	static const auto TexStorage2D = reinterpret_cast<PFN_TexStorage2D>(glfwGetProcAddress("glTexStorage2D"));
+	if(TexStorage2D)
 	{
-		glDeleteTextures(1, &channelB);
+		TexStorage2D(GL_TEXTURE_2D, levelCount, image.channels == 4 ? GL_RGBA8 : GL_RGB8, image.levels[0].width, image.levels[0].height);
+		for(GLsizei level = 0; level < levelCount; ++level)
+		{
+			const MipLevel& mip = image.levels[level];
+			glTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, mip.width, mip.height, format, GL_UNSIGNED_BYTE, mip.pixels.data());
+		}
 	}
-	if(data)
+	else
 	{
-		stbi_image_free(data);
+		for(GLsizei level = 0; level < levelCount; ++level)
+		{
+			const MipLevel& mip = image.levels[level];
+			glTexImage2D(GL_TEXTURE_2D, level, format, mip.width, mip.height, 0, format, GL_UNSIGNED_BYTE, mip.pixels.data());
+		}
 	}
 
-	glId = channelR = channelG = channelB = 0;
-	data = nullptr;
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levelCount - 1);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	ApplyChannelSwizzle(layout, swizzledChannel);
 }
 
-void PreviewTexture::GenerateChannelsFromRGB(unsigned char* src, int w, int h)
+void PreviewTexture::ShowChannel(ORMChannel channel)
 {
-	width = w;
-	height = h;
-
-	std::vector<unsigned char> red(w * h);
-	std::vector<unsigned char> green(w * h);
-	std::vector<unsigned char> blue(w * h);
-
-	for(int i = 0; i < w * h; ++i)
+	if(!glId || channel == swizzledChannel)
 	{
-		red[i] = src[i * 3 + 0];
-		green[i] = src[i * 3 + 1];
-		blue[i] = src[i * 3 + 2];
+		return;
 	}
 
-	const auto createTex = [] (GLuint& id, unsigned char* channelData, int w, int h)
-	{
-		glGenTextures(1, &id);
-		glBindTexture(GL_TEXTURE_2D, id);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, w, h, 0, GL_RED, GL_UNSIGNED_BYTE, channelData);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	};
-
-	createTex(channelR, red.data(), w, h);
-	createTex(channelG, green.data(), w, h);
-	createTex(channelB, blue.data(), w, h);
+	glBindTexture(GL_TEXTURE_2D, glId);
+	ApplyChannelSwizzle(layout, channel);
+	swizzledChannel = channel;
 }
 
-unsigned char* LoadGrayscale(const std::string& path, int& width, int& height)
+void UIManager::StartORMGeneration()
 {
-	int channels;
-	unsigned char* data = stbi_load(path.c_str(), &width, &height, &channels, 1);
-	if(!data) std::cerr << "Failed to load: " << path << "\n";
+	SaveData job;
+	job.ao = aoPreview.path;
+	job.rough = roughPreview.path;
+	job.metal = metallicPreview.path;
+	job.saveUnrealPath = outputUnreal;
+	job.saveUnityPath = outputUnity;
+	job.generateUnreal = generateUnrealORM;
+	job.generateUnity = generateUnityORM;
+	// all combos on Native (0) leave targetResolution at 0, so matching inputs are written as they are
+	job.targetResolution = std::max({ resolutionValues[aoResolutionIndex], resolutionValues[roughResolutionIndex], resolutionValues[metalResolutionIndex] });
+	job.streaming = streamingGeneration;
+	job.workerCount = workerCount;
+	job.pngOptions.compression = fastEncode ? PngCompression::Fast : PngCompression::Default;
+	job.pngOptions.bitDepth = highBitDepth ? 16 : 8;
+	job.dither = ditherInputs;
+	job.progressCallback = [this](float p) { ormProgress = p; };
+
+	// The packed buffer moves to the UI thread, which uploads it without decoding the file again
+	auto preview = std::make_shared<PreviewImage>();
+	ORMGenerator::Generate(job, preview.get(), previewDisplayWidth);
+	if(!preview->levels.empty())
+	{
+		std::lock_guard<std::mutex> lock(previewMutex);
+		pendingPreview = std::move(preview);
+	}
 
-	return data;
+	needsPreviewUpdate = true;
+	generatingORM = false;
 }
 
-bool UIManager::SaveUnrealAndUnityORM(const std::string& ao, const std::string& rough, const std::string& metal, const std::string& unrealPath, const std::string& unityPath,
-	bool doUnreal, bool doUnity,const std::function<void(float)>& progressCallback)
+void UIManager::WatchInputs()
 {
-	ormPreview.Unload();
-	int w1, h1, w2, h2, w3, h3;
-	unsigned char* aoData = LoadGrayscale(ao, w1, h1);
-	unsigned char* roughData = LoadGrayscale(rough, w2, h2);
-	unsigned char* metalData = LoadGrayscale(metal, w3, h3);
-
-	if(!aoData || !roughData || !metalData) return false;
-
-	if(w1 != w2 || w1 != w3 || h1 != h2 || h1 != h3)
+	inputWatcher.Clear();
+	for(const PreviewTexture* input : { &aoPreview, &roughPreview, &metallicPreview })
 	{
-		std::cerr << "Size mismatch!\n";
-		return false;
+		if(!input->path.empty())
+		{
+			inputWatcher.Watch(input->path);
+		}
 	}
+}
 
-	size_t count = w1 * h1;
-	float totalSteps = 0.0f;
-	if(doUnreal || doUnity)
+void UIManager::RegenerateChangedInputs()
+{
+	// Polled every frame; changes seen while the toggle is off or a job runs wait for the next chance
+	for(std::string& path : inputWatcher.Poll())
 	{
-		totalSteps += 2.0f;
+		changedInputs.insert(std::move(path));
 	}
-
-	float currentStep = 0.0f;
-
-	if(doUnreal)
+	if(changedInputs.empty() || !watchInputs || generatingORM)
 	{
-		std::vector<unsigned char> ormRGB(count * 3);
-		for(size_t i = 0; i < count; ++i)
-		{
-			ormRGB[i * 3 + 0] = aoData[i];
-			ormRGB[i * 3 + 1] = roughData[i];
-			ormRGB[i * 3 + 2] = metalData[i];
-
-			if(progressCallback && (i % (count / 100 + 1) == 0))
-			{
-				float pixelProgress = static_cast<float>(i) / count;
-				progressCallback((currentStep + pixelProgress) / totalSteps);
-			}
-		}
-		currentStep += 1.0f;
-
-		stbi_write_png(unrealPath.c_str(), w1, h1, 3, ormRGB.data(), w1 * 3);
-		currentStep += 1.0f;
-		if(progressCallback)
-		{
-			progressCallback(currentStep / totalSteps);
-		}
-
-		ormPreview.Unload();
-		ormPreview.path = unrealPath;
-		ormPreview.width = w1;
-		ormPreview.height = h1;
-		glGenTextures(1, &ormPreview.glId);
-		glBindTexture(GL_TEXTURE_2D, ormPreview.glId);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, w1, h1, 0, GL_RGB, GL_UNSIGNED_BYTE, ormRGB.data());
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-		ormPreview.GenerateChannelsFromRGB(ormRGB.data(), w1, h1);
+		return;
 	}
 
-	if(doUnity)
+	bool reloaded = false;
+	for(PreviewTexture* input : { &aoPreview, &roughPreview, &metallicPreview })
 	{
-		std::vector<unsigned char> ormRGBA(count * 4);
-
-		for(size_t i = 0; i < count; ++i)
+		if(!input->path.empty() && changedInputs.count(FileWatcher::NormalizePath(input->path)))
 		{
-			ormRGBA[i * 4 + 0] = metalData[i];
-			ormRGBA[i * 4 + 1] = aoData[i];
-			ormRGBA[i * 4 + 2] = 255;
-			ormRGBA[i * 4 + 3] = 255 - roughData[i];
-
-			if(progressCallback && (i % (count / 100 + 1) == 0))
-			{
-				float pixelProgress = static_cast<float>(i) / count;
-				progressCallback((currentStep + pixelProgress) / totalSteps);
-			}
+			const std::string path = input->path;
+			input->Load(path, ORMTool::ThumbnailSize);
+			reloaded = true;
 		}
-		currentStep += 1.0f;
-
-		stbi_write_png(unityPath.c_str(), w1, h1, 4, ormRGBA.data(), w1 * 4);
-		currentStep += 1.0f;
-		if(progressCallback) progressCallback(currentStep / totalSteps);
 	}
-
-	stbi_image_free(aoData);
-	stbi_image_free(roughData);
-	stbi_image_free(metalData);
-
-	if(progressCallback)
+	changedInputs.clear();
+	if(!reloaded)
 	{
-		progressCallback(1.0f);
+		return;
 	}
 
-	return true;
-}
-
-void UIManager::StartORMGeneration()
-{
-	SaveUnrealAndUnityORM(
-		aoPreview.path, roughPreview.path, metallicPreview.path,
-		outputUnreal, outputUnity,
-		generateUnrealORM, generateUnityORM, [this](float p) { ormProgress = p; }
-	);
-
-	needsPreviewUpdate = true;
-	generatingORM = false;
+	generatingORM = true;
+	ormProgress = 0.0f;
+	generationTask = ThreadPool::Get().Submit([this]() { StartORMGeneration(); });
 }
 
 void UIManager::VisibleProgressBar(const float progress)
@@ -297,18 +341,13 @@ void UIManager::LoadTextureDataFileDialog(PreviewTexture& tex, int& resolutionIn
 	{
 		tex.Unload();
 		tex.path = outPath;
-		if(tex.Load(outPath))
+		if(tex.Load(outPath, ORMTool::ThumbnailSize))
 		{
-			for(int i = 0; i < IM_ARRAYSIZE(resolutionValues); ++i)
-			{
-				if(tex.width == resolutionValues[i])
-				{
-					resolutionIndex = i;
-					break;
-				}
-			}
+			// a new input starts at its own size; picking a listed one resamples it
+			resolutionIndex = 0;
 		}
 		free(outPath);
+		WatchInputs();
 	}
 }
 
@@ -341,6 +380,15 @@ void UIManager::ShowMainUI()
 			ImGui::EndMenu();
 		}
 
+		if(ImGui::BeginMenu("Settings"))
+		{
+			ImGui::MenuItem(ORMTool::StreamingMenuTitle, nullptr, &streamingGeneration, !generatingORM);
+			ImGui::MenuItem(ORMTool::HighBitDepthMenuTitle, nullptr, &highBitDepth, !generatingORM);
+			ImGui::MenuItem(ORMTool::DitherMenuTitle, nullptr, &ditherInputs, !generatingORM && !highBitDepth);
+			ImGui::MenuItem(ORMTool::WatchMenuTitle, nullptr, &watchInputs);
+			ImGui::EndMenu();
+		}
+
 		if(ImGui::BeginMenu("About"))
 		{
 			if(ImGui::MenuItem("About"))
@@ -372,12 +420,11 @@ void UIManager::ShowMainUI()
 	{
 		generatingORM = true;
 		ormProgress = 0.0f;
-		loadingThread = std::thread(&UIManager::StartORMGeneration,this);
-		loadingThread.detach();
+		generationTask = ThreadPool::Get().Submit([this]() { StartORMGeneration(); });
 	}
 
 	static float DisplayedProgress = 0.0f;
-	DisplayedProgress = ImLerp(DisplayedProgress, ormProgress, ImGui::GetIO().DeltaTime * 8.0f);
+	DisplayedProgress = ImLerp(DisplayedProgress, ormProgress.load(), ImGui::GetIO().DeltaTime * 8.0f);
 	if(!generatingORM)
 	{
 		ormProgress = 0.0f;
@@ -389,6 +436,8 @@ void UIManager::ShowMainUI()
 	ImNeo::Checkbox(ORMTool::UnrealCBoxTitle, &generateUnrealORM, ORMTool::CheckboxSize);
 	ImGui::SameLine();
 	ImNeo::Checkbox(ORMTool::UnityCBoxTitle, &generateUnityORM, ORMTool::CheckboxSize);
+	ImGui::SameLine();
+	ImNeo::Checkbox(ORMTool::FastEncodeCBoxTitle, &fastEncode, ORMTool::CheckboxSize);
 	ImGui::SameLine(400.f, 2.0f);
 
 	ImGui::SetNextItemWidth(150.0f);
@@ -409,7 +458,7 @@ void UIManager::ShowMainUI()
 		ImGui::PushStyleColor(ImGuiCol_ButtonHovered, borderColor);
 		ImGui::PushStyleColor(ImGuiCol_ButtonActive, ImVec4(1.0f, 1.0f, 1.0f, 1.0f));
 
-		if(ImGui::ImageButton(label, (ImTextureID)(intptr_t)tex.glId, ImVec2(128, 128)))
+		if(ImGui::ImageButton(label, (ImTextureID)(intptr_t)tex.glId, ImVec2(ORMTool::ThumbnailSize, ORMTool::ThumbnailSize)))
 		{
 			LoadTextureDataFileDialog(tex, resolutionIndex);
 		}
@@ -432,11 +481,10 @@ void UIManager::ShowMainUI()
 	float previewWidth = ImGui::GetContentRegionAvail().x - 1.0f;
 	float aspect = ormPreview.width > 0 ? (float)ormPreview.height / ormPreview.width : 1.0f;
 	float previewHeight = previewWidth * aspect;
+	previewDisplayWidth = static_cast<int>(previewWidth * ImGui::GetIO().DisplayFramebufferScale.x);
 
+	ormPreview.ShowChannel(selectedChannel);
 	GLuint texId = ormPreview.glId;
-	if(selectedChannel == ORMChannel::AO_R) 			texId = ormPreview.channelR;
-	else if(selectedChannel == ORMChannel::Roughness_G) texId = ormPreview.channelG;
-	else if(selectedChannel == ORMChannel::Metallic_B) 	texId = ormPreview.channelB;
 
 
 
@@ -470,21 +518,35 @@ void UIManager::UpdatePreviewIfNeeded()
 {
 	if(!needsPreviewUpdate) return;
 
-	ormPreview.Unload();
-	ormPreview.path = outputUnreal;
-
-	int w, h, channels;
-	unsigned char* data = stbi_load(outputUnreal.c_str(), &w, &h, &channels, 3);
-	if(data) {
-		ormPreview.width = w;
-		ormPreview.height = h;
-		glGenTextures(1, &ormPreview.glId);
-		glBindTexture(GL_TEXTURE_2D, ormPreview.glId);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, w, h, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-		ormPreview.GenerateChannelsFromRGB(data, w, h);
-		stbi_image_free(data);
+	std::shared_ptr<PreviewImage> preview;
+	{
+		std::lock_guard<std::mutex> lock(previewMutex);
+		preview = std::move(pendingPreview);
+	}
+
+	// Streaming generation keeps no packed image around; only then is the written file decoded
+	if(!preview)
+	{
+		const bool unityOnly = !generateUnrealORM && generateUnityORM;
+		const int channels = unityOnly ? 4 : 3;
+
+		preview = std::make_shared<PreviewImage>();
+		preview->path = unityOnly ? outputUnity : outputUnreal;
+		preview->channels = channels;
+		preview->layout = unityOnly ? ORMLayout::UnityRGBA : ORMLayout::UnrealRGB;
+
+		int fileChannels = 0;
+		unsigned char* data = ImageLoader::Load(preview->path, preview->width, preview->height, fileChannels, channels);
+		if(data)
+		{
+			preview->levels = ORMGenerator::BuildPreviewLevels(data, preview->width, preview->height, channels, previewDisplayWidth);
+			ImageLoader::Free(data);
+		}
+	}
+
+	if(!preview->levels.empty())
+	{
+		ormPreview.Upload(*preview);
 	}
 
 	needsPreviewUpdate = false;
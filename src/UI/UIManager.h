@@ -7,12 +7,15 @@
 #include <array>
 #include <cmath>
 #include <map>
+#include <memory>
+#include <set>
 
 
 #include "backends/imgui_impl_glfw.h"
 #include "backends/imgui_impl_opengl3.h"
 
 #include "ImNeo.h"
+#include "FileWatcher.h"
 #include "Utils/Types.h"
 
 class UIManager final
@@ -31,18 +34,21 @@ private:
 	void ShowMainUI();
 	void UpdatePreviewIfNeeded();
 	void StartORMGeneration();
+	void WatchInputs();
+	void RegenerateChangedInputs();
 	void VisibleProgressBar(const float progress);
 	void LoadTextureDataFileDialog(PreviewTexture& tex, int& resolutionIndex);
 
-	// Image loading/generation
-	bool SaveUnrealAndUnityORM(const std::string& ao, const std::string& rough, const std::string& metal, const std::string& unrealPath, const std::string& unityPath,
-	bool doUnreal, bool doUnity, const std::function<void(float)>& progressCallback = nullptr);
-
 	// Internal state
 	PreviewTexture aoPreview, roughPreview, metallicPreview, ormPreview;
 
 	bool generateUnrealORM = true;
 	bool generateUnityORM = true;
+	bool fastEncode = false;		// fast PNG mode for iteration, full compression otherwise
+	bool streamingGeneration = false;	// pack and encode band by band, without full-size output buffers
+	bool highBitDepth = false;		// 16-bit inputs stay 16-bit through to the written files
+	bool ditherInputs = false;		// 8-bit output: 16-bit inputs are dithered down instead of truncated
+	bool watchInputs = false;		// regenerate when a loaded input is written again
 	ORMChannel selectedChannel = ORMChannel::AllRGB;
 
 	int aoResolutionIndex = 0;
@@ -50,7 +56,10 @@ private:
 	int metalResolutionIndex = 0;
 
 
-	float ormProgress = 0.0f;
+	unsigned int workerCount = 0;		// pack workers, 0 = one per hardware thread
+
+	std::atomic<float> ormProgress = 0.0f;
+	std::atomic<int> previewDisplayWidth = 544;	// viewport width in framebuffer pixels, sizes the preview mips
 	std::atomic<bool> needsPreviewUpdate = false;
 	std::atomic<bool> generatingORM = false;
 	std::atomic<bool> loadingTexture;
@@ -58,9 +67,14 @@ private:
 	std::string outputUnity = "orm_unity.png";
 
 	std::mutex loadingMutex;
-	std::thread loadingThread;
+	std::mutex previewMutex;
+	std::shared_ptr<PreviewImage> pendingPreview;		// packed result waiting for upload on the UI thread
+	std::future<void> generationTask;
+	FileWatcher inputWatcher;
+	std::set<std::string> changedInputs;		// normalized paths written since the last regeneration
 
-	static constexpr int resolutionValues[6] = { 128, 256, 512, 1024, 2048, 4096 };
-	static constexpr const char* resolutionOptions[6] = { "128","256","512","1024","2048","4096" };
+	// 0 = native: the input is written at the size it has unless another combo asks for more
+	static constexpr int resolutionValues[8] = { 0, 128, 256, 512, 1024, 2048, 4096, 8192 };
+	static constexpr const char* resolutionOptions[8] = { "Native","128","256","512","1024","2048","4096","8192" };
 };
 
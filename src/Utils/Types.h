@@ -2,7 +2,10 @@
 
 #include <string>
 #include <functional>
-#include <GLFW/glfw3.h>
+#include <vector>
+
+#include "MipPyramid.h"
+#include "PngOptions.h"
 
 /** enum channels  */
 enum class ORMChannel : int
@@ -13,35 +16,77 @@ enum class ORMChannel : int
 	Metallic_B
 };
 
+/** channel of an input image that becomes its grayscale plane */
+enum class SourceChannel : int
+{
+	Luma,		// weighted sum of the color channels
+	Red,
+	Green,
+	Blue,
+	Alpha		// opaque sources read as 255
+};
+
+/** channel order of a packed ORM image */
+enum class ORMLayout : int
+{
+	UnrealRGB,		// R = AO, G = roughness, B = metallic
+	UnityRGBA		// R = metallic, G = AO, A = smoothness
+};
+
+/** packed image handed from the generation pipeline to the UI thread for preview */
+struct PreviewImage
+{
+	std::vector<MipLevel> levels;	// mip chain sized for the viewport, largest first
+	std::string path;
+	int width = 0;			// source image size
+	int height = 0;
+	int channels = 0;
+	ORMLayout layout = ORMLayout::UnrealRGB;
+};
+
 /** preview texture data */
 struct PreviewTexture
 {
-	unsigned char* data = nullptr;
 	std::string path;
-	int width = 0;
+	int width = 0;			// source image size, the uploaded texture may be a thumbnail
 	int height = 0;			//
-	GLuint glId = 0;		// 4 byte
-	GLuint channelR = 0; 	// 4 byte
-	GLuint channelG = 0; 	// 4 byte
-	GLuint channelB = 0; 	// 4 byte
+	unsigned int glId = 0;	// GLuint, kept GL-free so headless targets can share this header
+	ORMLayout layout = ORMLayout::UnrealRGB;
+	ORMChannel swizzledChannel = ORMChannel::AllRGB;	// channel currently routed to RGB by the texture swizzle
 
-	/** loading texture */
-	bool Load(const std::string& p);
+	/** loading texture; downsampled to fit maxSize (0 = full size), CPU pixels are freed after upload */
+	bool Load(const std::string& p, int maxSize = 0);
+
+	/** replaces the texture with a packed ORM image; GL thread only */
+	void Upload(const PreviewImage& image);
 
 	/** unloading texture */
 	void Unload();
 
-	/** generate texture */
-	void GenerateChannelsFromRGB(unsigned char* src, int w, int h);
+	/** shows a single channel as grayscale (or all of them) through the texture swizzle; no-op if unchanged */
+	void ShowChannel(ORMChannel channel);
 };
 
+/** one packing job: inputs, outputs and how to produce them */
 struct SaveData
 {
 	std::string ao;
 	std::string rough;
 	std::string metal;
+	SourceChannel aoChannel = SourceChannel::Luma;
+	SourceChannel roughChannel = SourceChannel::Luma;
+	SourceChannel metalChannel = SourceChannel::Luma;
 	std::string saveUnrealPath;
 	std::string saveUnityPath;
 
-	std::function<void(float*)> progressCallback;
-};
\ No newline at end of file
+	bool generateUnreal = true;
+	bool generateUnity = true;
+	int targetResolution = 0;		// output width, 0 = widest input
+	bool streaming = false;			// pack and encode band by band, no full-size output buffers
+	bool dither = false;			// 8-bit output: decode 16-bit inputs and dither them down instead of truncating
+	unsigned int workerCount = 0;	// threads per stage, 0 = the whole pool
+	PngWriteOptions pngOptions;
+	std::string cacheDirectory;		// content-addressed output cache, empty = off
+
+	std::function<void(float)> progressCallback;
+};